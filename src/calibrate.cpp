@@ -1,28 +1,224 @@
 #include "calibrate.h"
 #include <Arduino.h>
 #include <Preferences.h>
+#include <algorithm>
 
 Preferences calPrefs;
 
 CalCoefficient calData[CAL_DATA_SIZE];
+float skyModel[SKY_MODEL_SIZE];
+
+const float skyModelDefault[SKY_MODEL_SIZE] = {0., 33., 0., 4., 100., 100., 0., 0.};
 
 void initCalPrefs() {
     calPrefs.begin("calPrefs", false);
     CalCoefficient defaultCal(1, 0);
     std::fill(std::begin(calData), std::end(calData), defaultCal);
+    std::copy(std::begin(skyModelDefault), std::end(skyModelDefault), std::begin(skyModel));
     loadCalPrefs();
 }
 
+// Linear coefficients of a channel, also the layout of the version 1 calData blob
+struct CalLinear {
+    float a;
+    float b;
+};
+
+// Points of a channel table, slopes and coefficients are refitted on load
+struct CalTableRecord {
+    uint8_t mode;
+    uint8_t degree;
+    uint8_t points;
+    float x[CAL_TABLE_POINTS];
+    float y[CAL_TABLE_POINTS];
+};
+
+String calTableKey(int i) {
+    return "calTable" + String(i);
+}
+
 void loadCalPrefs() {
-    if (calPrefs.isKey("calData")) {
-        calPrefs.getBytes("calData", calData, sizeof(calData));
+    if (calPrefs.isKey("skyModel")) {
+        calPrefs.getBytes("skyModel", skyModel, sizeof(skyModel));
+    }
+    CalLinear linear[CAL_DATA_SIZE];
+    uint8_t version = calPrefs.getUChar("calVersion", 1);
+    if (version < 2) {
+        // Version 1 - migrate the raw blob to the current layout
+        if (calPrefs.isKey("calData") && calPrefs.getBytes("calData", linear, sizeof(linear)) == sizeof(linear)) {
+            for (int i = 0; i < CAL_DATA_SIZE; i++) {
+                calData[i] = CalCoefficient(linear[i].a, linear[i].b);
+            }
+            saveCalPrefs();
+            calPrefs.remove("calData");
+        }
+        return;
+    }
+    if (calPrefs.isKey("calLinear") && calPrefs.getBytes("calLinear", linear, sizeof(linear)) == sizeof(linear)) {
+        for (int i = 0; i < CAL_DATA_SIZE; i++) {
+            calData[i].a = linear[i].a;
+            calData[i].b = linear[i].b;
+        }
+    }
+    for (int i = 0; i < CAL_DATA_SIZE; i++) {
+        CalTableRecord record;
+        String key = calTableKey(i);
+        if (calPrefs.isKey(key.c_str()) && calPrefs.getBytes(key.c_str(), &record, sizeof(record)) == sizeof(record)) {
+            CalCoefficient &c = calData[i];
+            c.mode = record.mode;
+            c.degree = record.degree;
+            c.points = min(record.points, (uint8_t)CAL_TABLE_POINTS);
+            std::copy(record.x, record.x + c.points, c.x);
+            std::copy(record.y, record.y + c.points, c.y);
+            fitCalTable(c);
+        }
     }
 }
 
 void saveCalPrefs() {
-    calPrefs.putBytes("calData", calData, sizeof(calData));
+    CalLinear linear[CAL_DATA_SIZE];
+    for (int i = 0; i < CAL_DATA_SIZE; i++) {
+        linear[i] = {calData[i].a, calData[i].b};
+        // Only channels with points keep a table record
+        String key = calTableKey(i);
+        if (calData[i].points > 0) {
+            CalTableRecord record = {calData[i].mode, calData[i].degree, calData[i].points};
+            std::copy(calData[i].x, calData[i].x + CAL_TABLE_POINTS, record.x);
+            std::copy(calData[i].y, calData[i].y + CAL_TABLE_POINTS, record.y);
+            calPrefs.putBytes(key.c_str(), &record, sizeof(record));
+        } else if (calPrefs.isKey(key.c_str())) {
+            calPrefs.remove(key.c_str());
+        }
+    }
+    calPrefs.putBytes("calLinear", linear, sizeof(linear));
+    calPrefs.putBytes("skyModel", skyModel, sizeof(skyModel));
+    calPrefs.putUChar("calVersion", CAL_PREFS_VERSION);
 }
 
-float calibrate(float v, CalCoefficient c) {
+float calibrate(float v, const CalCoefficient &c) {
+    if (c.fitted) {
+        if (c.mode == CalMode::Piecewise) {
+            // Segment of v by binary search, end segments extrapolate
+            int s = std::upper_bound(c.x, c.x + c.points, v) - c.x - 1;
+            s = constrain(s, 0, c.points - 2);
+            v = c.y[s] + c.k[s] * (v - c.x[s]);
+        } else {
+            float u = (v - c.x0) / c.scale;
+            float p = 0;
+            for (int i = c.degree; i >= 0; i--) {
+                p = p * u + c.k[i];
+            }
+            v = p;
+        }
+    }
     return c.a * v + c.b;
-}
\ No newline at end of file
+}
+
+bool addCalPoint(CalCoefficient &c, float x, float y) {
+    int i = std::lower_bound(c.x, c.x + c.points, x) - c.x;
+    if (i < c.points && c.x[i] == x) {
+        c.y[i] = y;
+    } else {
+        if (c.points >= CAL_TABLE_POINTS) {
+            return false;
+        }
+        // Keep the points sorted for the segment search
+        std::copy_backward(c.x + i, c.x + c.points, c.x + c.points + 1);
+        std::copy_backward(c.y + i, c.y + c.points, c.y + c.points + 1);
+        c.x[i] = x;
+        c.y[i] = y;
+        c.points++;
+    }
+    fitCalTable(c);
+    return true;
+}
+
+bool setCalMode(CalCoefficient &c, uint8_t mode, uint8_t degree) {
+    c.mode = mode;
+    c.degree = constrain(degree, 1, CAL_POLY_MAX_DEGREE);
+    if (mode == CalMode::Linear) {
+        c.points = 0;
+    }
+    return fitCalTable(c);
+}
+
+bool fitCalTable(CalCoefficient &c) {
+    c.fitted = false;
+    if (c.mode == CalMode::Piecewise) {
+        if (c.points < 2) {
+            return false;
+        }
+        for (int i = 0; i < c.points - 1; i++) {
+            c.k[i] = (c.y[i + 1] - c.y[i]) / (c.x[i + 1] - c.x[i]);
+        }
+        c.fitted = true;
+    } else if (c.mode == CalMode::Polynomial) {
+        int n = c.degree + 1;
+        if (c.points < n) {
+            return false;
+        }
+        // Fit in u = (x - x0) / scale over [-1, 1], raw powers of e.g. hPa are ill-conditioned in float
+        double sum = 0;
+        for (int p = 0; p < c.points; p++) {
+            sum += c.x[p];
+        }
+        c.x0 = sum / c.points;
+        c.scale = (c.x[c.points - 1] - c.x[0]) / 2;
+        if (c.scale <= 0) {
+            c.scale = 1;
+        }
+        // Least squares normal equations, Gaussian elimination with partial pivoting
+        double m[CAL_POLY_MAX_DEGREE + 1][CAL_POLY_MAX_DEGREE + 2] = {};
+        for (int p = 0; p < c.points; p++) {
+            double u = (c.x[p] - c.x0) / c.scale;
+            double xp[2 * CAL_POLY_MAX_DEGREE + 1];
+            xp[0] = 1;
+            for (int i = 1; i < 2 * n - 1; i++) {
+                xp[i] = xp[i - 1] * u;
+            }
+            for (int r = 0; r < n; r++) {
+                for (int col = 0; col < n; col++) {
+                    m[r][col] += xp[r + col];
+                }
+                m[r][n] += xp[r] * c.y[p];
+            }
+        }
+        for (int col = 0; col < n; col++) {
+            int pivot = col;
+            for (int r = col + 1; r < n; r++) {
+                if (fabs(m[r][col]) > fabs(m[pivot][col])) {
+                    pivot = r;
+                }
+            }
+            if (fabs(m[pivot][col]) < 1e-12) {
+                return false;
+            }
+            for (int i = 0; i <= n; i++) {
+                std::swap(m[col][i], m[pivot][i]);
+            }
+            for (int r = 0; r < n; r++) {
+                if (r != col) {
+                    double f = m[r][col] / m[col][col];
+                    for (int i = col; i <= n; i++) {
+                        m[r][i] -= f * m[col][i];
+                    }
+                }
+            }
+        }
+        for (int i = 0; i < n; i++) {
+            c.k[i] = m[i][n] / m[i][i];
+        }
+        c.fitted = true;
+    }
+    return c.fitted;
+}
+
+String calModeAsString(uint8_t mode) {
+    switch (mode) {
+    case CalMode::Piecewise:
+        return "piecewise";
+    case CalMode::Polynomial:
+        return "poly";
+    }
+    return "linear";
+}
@@ -4,6 +4,13 @@
 #include <String.h>
 
 #define CAL_DATA_SIZE 32
+// Sky temperature model coefficients k1..k7, index 0 unused
+#define SKY_MODEL_SIZE 8
+// Reference points of a calibration table
+#define CAL_TABLE_POINTS 8
+#define CAL_POLY_MAX_DEGREE 3
+// Calibration persistence layout, 1 - raw calData blob of linear coefficients
+#define CAL_PREFS_VERSION 2
 
 #define CAL_BMP280_TEMPERATURE calData[CalDevice::BMP280Temperature]
 #define CAL_BMP280_PRESSURE calData[CalDevice::BMP280Pressure]
@@ -50,22 +57,56 @@ class CalDevice {
     static const int RG15RainRate = 19;
 };
 
+class CalMode {
+  public:
+    static const uint8_t Linear = 0;
+    // Linear interpolation between the points, end segments extrapolated
+    static const uint8_t Piecewise = 1;
+    // Least squares polynomial through the points
+    static const uint8_t Polynomial = 2;
+};
+
+// Linear trim y = a*x + b, applied after the optional point table
 struct CalCoefficient {
     float a;
     float b;
-    CalCoefficient() {
-        a = 1;
-        b = 0;
-    }
+    uint8_t mode;
+    uint8_t degree;
+    uint8_t points;
+    // Table fitted and used per sample
+    bool fitted;
+    // Reference points, sorted by x
+    float x[CAL_TABLE_POINTS];
+    float y[CAL_TABLE_POINTS];
+    // Segment slopes (piecewise) or polynomial coefficients, lowest order first
+    float k[CAL_TABLE_POINTS];
+    // Polynomial variable u = (x - x0) / scale, centre and half-range of the points
+    float x0;
+    float scale;
+    CalCoefficient() : CalCoefficient(1, 0) {}
     CalCoefficient(float _a, float _b) {
         a = _a;
         b = _b;
+        mode = CalMode::Linear;
+        degree = 1;
+        points = 0;
+        fitted = false;
+        x0 = 0;
+        scale = 1;
     }
 };
 
 extern CalCoefficient calData[CAL_DATA_SIZE];
+extern float skyModel[SKY_MODEL_SIZE];
 
 void initCalPrefs();
 void loadCalPrefs();
 void saveCalPrefs();
-float calibrate(float, CalCoefficient);
+float calibrate(float, const CalCoefficient &);
+// Add a reference point (raw x, true y), a point with the same x is replaced
+bool addCalPoint(CalCoefficient &, float, float);
+// Select table mode and polynomial degree, refits the table
+bool setCalMode(CalCoefficient &, uint8_t, uint8_t);
+// Precompute segment slopes or polynomial coefficients from the points
+bool fitCalTable(CalCoefficient &);
+String calModeAsString(uint8_t);
@@ -0,0 +1,58 @@
+#include "cloudcover.h"
+
+void CloudClassifier::add(float object, float ambient, float dewPoint) {
+    float delta = object - ambient;
+    deltaStats.add(delta);
+    // Berdahl-Martin clear-sky emissivity from the dew point, sky temperature = e^(1/4) * ambient
+    float td = dewPoint / 100.;
+    float emissivity = 0.711 + 0.56 * td + 0.73 * td * td;
+    emissivity = constrain(emissivity, 0.5, 1.0);
+    float ambientK = ambient + 273.15;
+    threshold = sqrtf(sqrtf(emissivity)) * ambientK - ambientK;
+    // Linear position between clear sky and overcast
+    float fraction = 1;
+    if (threshold < CLOUD_OVERCAST_DELTA) {
+        fraction = (delta - threshold) / (CLOUD_OVERCAST_DELTA - threshold);
+    }
+    fraction = constrain(fraction, 0, 1);
+    if (!started) {
+        percent = fraction * 100;
+        started = true;
+    } else {
+        percent += CLOUD_SMOOTHING * (fraction * 100 - percent);
+    }
+    if (percent < CLOUD_CLEAR_MAX) {
+        cloudClass = CloudClass::Clear;
+    } else if (percent < CLOUD_PARTLY_MAX) {
+        cloudClass = CloudClass::Partly;
+    } else if (percent < CLOUD_CLOUDY_MAX) {
+        cloudClass = CloudClass::Cloudy;
+    } else {
+        cloudClass = CloudClass::Overcast;
+    }
+    // Clouds passing over a mostly clear sky show up as delta variance first
+    if (cloudClass == CloudClass::Clear && getDeltaStdDev() > CLOUD_BROKEN_STDDEV) {
+        cloudClass = CloudClass::Partly;
+    }
+}
+
+void CloudClassifier::clear() {
+    deltaStats.clear();
+    percent = 0;
+    cloudClass = CloudClass::Clear;
+    started = false;
+}
+
+String CloudClassifier::classAsString(int c) {
+    switch (c) {
+    case CloudClass::Clear:
+        return "clear";
+    case CloudClass::Partly:
+        return "partly";
+    case CloudClass::Cloudy:
+        return "cloudy";
+    case CloudClass::Overcast:
+        return "overcast";
+    }
+    return "unknown";
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+#include "statistics.h"
+#include <Arduino.h>
+
+// Sky-minus-ambient delta of a low overcast, °C
+#define CLOUD_OVERCAST_DELTA -3.0
+// Delta variance window, samples (1 minute at 3 s)
+#define CLOUD_VARIANCE_WINDOW 20
+// Delta standard deviation of broken clouds, °C
+#define CLOUD_BROKEN_STDDEV 0.5
+// Percentage smoothing factor per sample
+#define CLOUD_SMOOTHING 0.2
+// Class upper bounds, %
+#define CLOUD_CLEAR_MAX 20
+#define CLOUD_PARTLY_MAX 60
+#define CLOUD_CLOUDY_MAX 90
+
+class CloudClass {
+  public:
+    static const int Clear = 0;
+    static const int Partly = 1;
+    static const int Cloudy = 2;
+    static const int Overcast = 3;
+};
+
+// Cloud cover from the IR sky-minus-ambient delta against a clear-sky threshold, O(1) per sample
+class CloudClassifier {
+  private:
+    RollingStatistics deltaStats = RollingStatistics(CLOUD_VARIANCE_WINDOW);
+    float percent = 0;
+    float threshold = 0;
+    int cloudClass = CloudClass::Clear;
+    bool started = false;
+
+  public:
+    // Add a sample: object and ambient IR temperatures and the dew point, °C
+    void add(float object, float ambient, float dewPoint);
+    void clear();
+    // Smoothed cloud cover, %
+    float getPercent() { return percent; }
+    int getClass() { return cloudClass; }
+    // Expected clear-sky delta for the last sample, °C
+    float getClearThreshold() { return threshold; }
+    float getDeltaStdDev() { return sqrtf(deltaStats.getVariance()); }
+    static String classAsString(int);
+};
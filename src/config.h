@@ -9,6 +9,8 @@
 #define NTP_INTERVAL_SHORT 10
 #define NTP_INTERVAL_LONG 900
 #define NTP_SERVER "time.google.com"
+// Epoch seconds before the clock is considered set by NTP or RTC
+#define NTP_TIME_VALID 1600000000
 
 // ASCOM Alpaca
 #define ALPACA_UDP_PORT 32227
@@ -45,6 +47,12 @@
 // WIND
 #define WIND_SENSOR_PIN 7
 #define WIND_SENSOR_MEASURE 1000
+// Wind vane, resistor ladder with pull-up to 3.3V
+#define WIND_VANE_PIN 2
+// ESP32-S3 GPIO1..GPIO10 are ADC1 channels 0..9
+#define WIND_VANE_CHANNEL ((adc1_channel_t)(WIND_VANE_PIN - 1))
+#define WIND_VANE_PULLUP 10000
+#define WIND_VANE_SUPPLY_MV 3300
 
 // MQTT
 #define MQTT_STATUS_DELAY 20000
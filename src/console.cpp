@@ -1,8 +1,15 @@
 #include "console.h"
 #include "calibrate.h"
+#include "dewpoint.h"
+#include "filter.h"
 #include "hardware.h"
 #include "helpers.h"
+#include "history.h"
 #include "log.h"
+#include "rollup.h"
+#include "settings.h"
+#include "tslog.h"
+#include "warmstart.h"
 #include "weights.h"
 #include <Arduino.h>
 #include <algorithm>
@@ -10,6 +17,7 @@
 #include <map>
 #include <sstream>
 #include <string>
+#include <vector>
 
 std::map<std::string, std::function<void()>> console_commands;
 
@@ -27,6 +35,10 @@ void commandHelp() {
     logConsoleMessage("[HELP]   help temp    - show help about temperature calc weights");
     logConsoleMessage("[HELP]   help humi    - show help about humidity calc weights");
     logConsoleMessage("[HELP]   help cal     - show help about calibration settings");
+    logConsoleMessage("[HELP]   help filter  - show help about outlier filter settings");
+    logConsoleMessage("[HELP]   help sht     - show help about SHT45 precision settings");
+    logConsoleMessage("[HELP]   help sky     - show help about sky temperature noise settings");
+    logConsoleMessage("[HELP]   help bench   - show help about on-device benchmarks");
 }
 
 void commandHelpInfo() {
@@ -39,7 +51,27 @@ void commandHelpInfo() {
     logConsoleMessage("[HELP]   hw     - show current hw settings");
     logConsoleMessage("[HELP]   temp   - show current temperature calc weights");
     logConsoleMessage("[HELP]   humi   - show current humidity calc weights");
+    logConsoleMessage("[HELP]   fusion - show current temperature and humidity fusion state");
+    logConsoleMessage("[HELP]   drift  - show cross-sensor drift and suggested calibration offsets");
+    logConsoleMessage("[HELP]   drift reset - restart cross-sensor drift tracking");
+    logConsoleMessage("[HELP]   quantiles - show wind, sky temperature and sky quality percentiles");
+    logConsoleMessage("[HELP]   quantiles reset - restart percentile estimation");
+    logConsoleMessage("[HELP]   history - show sensor history store state");
+    logConsoleMessage("[HELP]   history channels - list channels kept in the history");
+    logConsoleMessage("[HELP]   history <channel> [hh:mm] [minutes] - channel values of the last minutes or from hh:mm, 10 minutes by default");
+    logConsoleMessage("[HELP]   tslog  - show flash minute log state");
+    logConsoleMessage("[HELP]   tslog <channel> [hours] - channel min/mean/max from the flash log, 24 hours by default");
+    logConsoleMessage("[HELP]   tslog retention n - return n days (0 - all) of the flash log");
+    logConsoleMessage("[HELP]   tslog format - erase the flash log");
+    logConsoleMessage("[HELP]   rollup - show 1 min/10 min/1 h/1 day rollup tiers");
+    logConsoleMessage("[HELP]   rollup <channel> <range> [resolution] - min/mean/max of the last range, e.g. rollup wind_gust 7d, rollup sky_quality 30d 1d");
+    logConsoleMessage("[HELP]   warmstart - show the averages and safety state checkpoint for a warm start");
+    logConsoleMessage("[HELP]   trend  - show pressure tendency and temperature, humidity and sky temperature trends");
+    logConsoleMessage("[HELP]   warmstart age n - restore a checkpoint up to n seconds old at boot (0 - always a cold start)");
     logConsoleMessage("[HELP]   cal    - show current calibration settings");
+    logConsoleMessage("[HELP]   filter - show current outlier filter settings and rejections");
+    logConsoleMessage("[HELP]   sht    - show current SHT45 precision settings");
+    logConsoleMessage("[HELP]   sky    - show current sky temperature noise settings");
     logConsoleMessage("[HELP]   uptime - show current system uptime");
     logConsoleMessage("[HELP]   faults - show current sensor faults");
     logConsoleMessage("[HELP] General:");
@@ -91,6 +123,7 @@ void commandHelpHw() {
     logConsoleMessage("[HELP]   hw anemo4403 on/off - enable/disable ANEMO4403 sensor");
     logConsoleMessage("[HELP]   hw uicpal on/off    - enable/disable UICPAL sensor");
     logConsoleMessage("[HELP]   hw rg15 on/off      - enable/disable RG-15 sensor");
+    logConsoleMessage("[HELP]   hw windvane on/off  - enable/disable wind vane");
     logConsoleMessage("[HELP] Alpaca settings (reboot required):");
     logConsoleMessage("[HELP]   alpaca obscon on/off  - enable/disable observing conditions service");
     logConsoleMessage("[HELP]   alpaca safemon on/off - enable/disable safety monitor service");
@@ -115,6 +148,9 @@ void commandHelpTemp() {
     logConsoleMessage("[HELP]   humi sht n.nn - set SHT45 humidity calc weight");
     logConsoleMessage("[HELP]   humi aht n.nn - set AHT20 humidity calc weight");
     logConsoleMessage("[HELP]   humi weight n.nn n.nn - set SHT45/AHT20 humidity calc weights at once");
+    logConsoleMessage("[HELP] Online fusion (calc weights used as priors):");
+    logConsoleMessage("[HELP]   fusion        - show current fusion weights, noise and bias");
+    logConsoleMessage("[HELP]   fusion on/off - enable/disable inverse-variance fusion");
 }
 
 void commandHelpHumi() {
@@ -150,6 +186,60 @@ void commandHelpCal() {
     logConsoleMessage("[HELP]   cal temp <a> <b>        - set temperature calibration");
     logConsoleMessage("[HELP]   cal humi <a> <b>        - set humidity calibration");
     logConsoleMessage("[HELP]   cal dew <a> <b>         - set dew point calibration");
+    logConsoleMessage("[HELP] Tables T(x) of up to " + String(CAL_TABLE_POINTS) + " points, applied before a*x + b:");
+    logConsoleMessage("[HELP]   cal point <sensor> <x> <y>        - add raw x / true y point, e.g. cal point anemo wind 12.5 5.2");
+    logConsoleMessage("[HELP]   cal table <sensor>                - show table points and fit");
+    logConsoleMessage("[HELP]   cal table <sensor> piecewise      - interpolate between the points");
+    logConsoleMessage("[HELP]   cal table <sensor> poly <n>       - least squares polynomial of degree n (1-" + String(CAL_POLY_MAX_DEGREE) + ")");
+    logConsoleMessage("[HELP]   cal table <sensor> linear         - drop the table points");
+}
+void commandHelpFilter() {
+    logConsoleMessage("[HELP] ---------------------------------");
+    logConsoleMessage("[HELP] Available outlier filter commands");
+    logConsoleMessage("[HELP] ---------------------------------");
+    logConsoleMessage("[HELP] Raw readings are filtered before calibration, channels are named as in cal commands");
+    logConsoleMessage("[HELP]   filter                          - show current filter settings and rejected/total samples");
+    logConsoleMessage("[HELP]   filter reset                    - reset rejection counters");
+    logConsoleMessage("[HELP]   filter <channel> off            - disable channel filter, e.g. filter mlx obj off");
+    logConsoleMessage("[HELP]   filter <channel> hampel n k [f] - replace samples beyond k robust sigmas (floor f) of n (3-" + String(FILTER_MAX_WINDOW) + ") sample median");
+    logConsoleMessage("[HELP]   filter <channel> median n [k]   - median of n (3-" + String(FILTER_MAX_WINDOW) + ") samples, k counts rejections");
+    logConsoleMessage("[HELP] Channels: bmp temp, bmp pres, aht temp, aht humi, sht temp, sht humi, mlx amb, mlx obj, tsl bright, rg rain");
+}
+
+void commandHelpSht() {
+    logConsoleMessage("[HELP] ----------------------------------");
+    logConsoleMessage("[HELP] Available SHT45 precision commands");
+    logConsoleMessage("[HELP] ----------------------------------");
+    logConsoleMessage("[HELP]   sht                          - show current SHT45 precision settings");
+    logConsoleMessage("[HELP]   sht precision high/medium/low - set SHT45 measure precision");
+    logConsoleMessage("[HELP]   sht oversampling n           - average n (1-" + String(SHT45_MAX_OVERSAMPLING) + ") measures per reading");
+    logConsoleMessage("[HELP]   sht spread on/off            - spread oversampling measures across the sampling window");
+    logConsoleMessage("[HELP]   sht report                   - measure noise and bus time of every precision mode");
+}
+
+void commandHelpSky() {
+    logConsoleMessage("[HELP] ----------------------------------------");
+    logConsoleMessage("[HELP] Available sky temperature noise commands");
+    logConsoleMessage("[HELP] ----------------------------------------");
+    logConsoleMessage("[HELP]   sky          - show current sky temperature noise settings");
+    logConsoleMessage("[HELP]   sky window n - noise window of n (2-" + String(STAT_MAX_WINDOW) + ") samples");
+    logConsoleMessage("[HELP]   sky model <k1> <k2> <k3> <k4> <k5> <k6> <k7> - set sky temperature model coefficients");
+    logConsoleMessage("[HELP]   sky model default - restore default sky temperature model coefficients");
+    logConsoleMessage("[HELP]   sky highrate on/off - " + String(1000 / TURBULENCE_SAMPLE_MS) + " Hz sampling with FFT turbulence index as FWHM proxy");
+}
+
+void commandHelpBench() {
+    logConsoleMessage("[HELP] ------------------------------");
+    logConsoleMessage("[HELP] Available on-device benchmarks");
+    logConsoleMessage("[HELP] ------------------------------");
+    logConsoleMessage("[HELP]   bench anemo  - ANEMO4403 pulse counter window query cost");
+    logConsoleMessage("[HELP]   bench sky    - sky temperature model accuracy and cost, float vs double");
+    logConsoleMessage("[HELP]   bench dew    - dew/frost point accuracy and cost, float vs double");
+    logConsoleMessage("[HELP]   bench obscon - alpaca average lookup latency under concurrent pollers");
+    logConsoleMessage("[HELP]   bench history - history store footprint, append cost and query throughput");
+    logConsoleMessage("[HELP]   bench tslog  - flash log write amplification and scan speed on a simulated partition");
+    logConsoleMessage("[HELP]   bench rollup - rollup query cost against a minute scan");
+    logConsoleMessage("[HELP]   bench trend  - sliding regression against a 3 hour buffer rescan");
 }
 
 void commandLogState() {
@@ -191,6 +281,7 @@ void commandHardwareState() {
     logConsoleMessage("[INFO]   ANEMO4403 - " + String(HARDWARE_ANEMO4403 ? "enabled" : "disabled") + String(!HARDWARE_ANEMO4403 ? "" : (INITED_ANEMO4403 ? ", OK" : ", FAULT")) + " (wind speed)");
     logConsoleMessage("[INFO]   UICPAL    - " + String(HARDWARE_UICPAL ? "enabled" : "disabled") + String(!HARDWARE_UICPAL ? "" : (INITED_UICPAL ? ", OK" : ", FAULT")) + " (rain/snow sensor)");
     logConsoleMessage("[INFO]   RG15      - " + String(HARDWARE_RG15 ? "enabled" : "disabled") + String(!HARDWARE_RG15 ? "" : (INITED_RG15 ? ", OK" : ", FAULT")) + " (rain rate sensor)");
+    logConsoleMessage("[INFO]   WINDVANE  - " + String(HARDWARE_WINDVANE ? "enabled" : "disabled") + String(!HARDWARE_WINDVANE ? "" : (INITED_WINDVANE ? ", OK" : ", FAULT")) + " (wind direction)");
     logConsoleMessage("[INFO] Alpaca:");
     logConsoleMessage("[INFO]   Observing conditions - " + String(ALPACA_OBSCON ? "enabled" : "disabled"));
     logConsoleMessage("[INFO]   Safety monitor       - " + String(ALPACA_SAFEMON ? "enabled" : "disabled"));
@@ -217,7 +308,7 @@ void commandHardwareState() {
     logConsoleMessage("[INFO]   Wind speed      - " + String(SAFEMON_WINDSPEED ? "enabled" : "disabled"));
 }
 
-String calCoeffAsString(CalCoefficient c) {
+String calCoeffAsString(const CalCoefficient &c) {
     String result = "y = ";
     if (c.a == 0) {
         result += String(c.b);
@@ -225,7 +316,7 @@ String calCoeffAsString(CalCoefficient c) {
         if (c.a != 1) {
             result += String(c.a) + "*";
         }
-        result += "x";
+        result += c.fitted ? "T(x)" : "x";
         if (c.b != 0) {
             if (c.b > 0) {
                 result += " + " + String(c.b);
@@ -234,6 +325,9 @@ String calCoeffAsString(CalCoefficient c) {
             }
         }
     }
+    if (c.points > 0) {
+        result += ", T - " + calModeAsString(c.mode) + (c.mode == CalMode::Polynomial ? " " + String(c.degree) : "") + " of " + String(c.points) + " points" + (c.fitted ? "" : " (not fitted)");
+    }
     return result;
 }
 
@@ -265,6 +359,205 @@ void commandCalibrateState() {
     logConsoleMessage("[INFO]   Dew Point                - " + calCoeffAsString(CAL_DEW_POINT));
 }
 
+struct FilterChannel {
+    const char *key;
+    const char *name;
+    int channel;
+};
+
+const FilterChannel filterChannels[] = {
+    {"bmptemp", "BMP280 Temperature    ", CalDevice::BMP280Temperature},
+    {"bmppres", "BMP280 Pressure       ", CalDevice::BMP280Pressure},
+    {"ahttemp", "AHT20 Temperature     ", CalDevice::AHT20Temperature},
+    {"ahthumi", "AHT20 Humidity        ", CalDevice::AHT20Humidity},
+    {"shttemp", "SHT45 Temperature     ", CalDevice::SHT45Temperature},
+    {"shthumi", "SHT45 Humidity        ", CalDevice::SHT45Humidity},
+    {"mlxamb", "MLX90614 Ambient      ", CalDevice::MLX90614Ambient},
+    {"mlxobj", "MLX90614 Object       ", CalDevice::MLX90614Object},
+    {"tslbright", "TSL2591 Sky Brightness", CalDevice::TSL2591SkyBrightness},
+    {"rgrain", "RG15 Rain Rate        ", CalDevice::RG15RainRate},
+};
+
+void commandFilterState() {
+    logConsoleMessage("[INFO] -------------------------------------");
+    logConsoleMessage("[INFO] Outlier filter (ahead of calibration)");
+    logConsoleMessage("[INFO] -------------------------------------");
+    for (const FilterChannel &f : filterChannels) {
+        FilterConfig &c = filterConfig[f.channel];
+        OutlierFilter &o = outlierFilter[f.channel];
+        String line = "[INFO]   " + String(f.name) + " - " + filterModeAsString(c.mode);
+        if (c.mode != FilterMode::Off) {
+            line += " n=" + String(c.window) + " k=" + String(c.threshold, 1) + " floor=" + String(c.floor, 2);
+        }
+        line += ", rejected " + String(o.getRejected()) + "/" + String(o.getTotal());
+        logConsoleMessage(line);
+    }
+}
+
+void commandFilterReset() {
+    for (int i = 0; i < CAL_DATA_SIZE; i++) {
+        outlierFilter[i].resetCounters();
+    }
+    commandFilterState();
+}
+
+void commandFilter(const std::string &msg) {
+    std::istringstream iss(msg);
+    std::string word, key;
+    iss >> word;
+    uint8_t mode = 0xff;
+    // Channel name words until the mode
+    while (iss >> word) {
+        std::transform(word.begin(), word.end(), word.begin(), ::tolower);
+        if (word == "off") {
+            mode = FilterMode::Off;
+        } else if (word == "hampel") {
+            mode = FilterMode::Hampel;
+        } else if (word == "median") {
+            mode = FilterMode::Median;
+        } else {
+            key += word;
+            continue;
+        }
+        break;
+    }
+    const FilterChannel *f = nullptr;
+    for (const FilterChannel &c : filterChannels) {
+        if (key == c.key) {
+            f = &c;
+        }
+    }
+    if (f == nullptr || mode == 0xff) {
+        logConsoleMessage("[CONSOLE] Unknown filter channel or mode, use command \"help filter\" please");
+        return;
+    }
+    FilterConfig &c = filterConfig[f->channel];
+    c.mode = mode;
+    int window;
+    float threshold, floor;
+    if (iss >> window) {
+        c.window = constrain(window, 3, FILTER_MAX_WINDOW);
+        if (iss >> threshold) {
+            c.threshold = threshold;
+            if (iss >> floor) {
+                c.floor = floor;
+            }
+        }
+    }
+    saveFilterPrefs();
+    outlierFilter[f->channel].resetCounters();
+    commandFilterState();
+}
+
+// Calibration channel of the sensor words of a cal command, e.g. "bmp temp", -1 if unknown
+int calChannel(const std::string &sensor) {
+    static const std::map<std::string, int> channels = {
+        {"calbmptemp", CalDevice::BMP280Temperature},
+        {"calbmppres", CalDevice::BMP280Pressure},
+        {"calahttemp", CalDevice::AHT20Temperature},
+        {"calahthumi", CalDevice::AHT20Humidity},
+        {"calshttemp", CalDevice::SHT45Temperature},
+        {"calshthumi", CalDevice::SHT45Humidity},
+        {"caldewpoint", CalDevice::DewPoint},
+        {"caltemp", CalDevice::Temperature},
+        {"calhumi", CalDevice::Humidity},
+        {"calrain", CalDevice::RainRate},
+        {"calmlxamb", CalDevice::MLX90614Ambient},
+        {"calmlxobj", CalDevice::MLX90614Object},
+        {"calmlxsky", CalDevice::MLX90614SkyTemperature},
+        {"calmlxcloud", CalDevice::MLX90614CloudCover},
+        {"caltslbright", CalDevice::TSL2591SkyBrightness},
+        {"caltslsky", CalDevice::TSL2591SkyQuality},
+        {"caltslsqm", CalDevice::TSL2591SkyQuality},
+        {"calanemowind", CalDevice::ANEMO4403WindSpeed},
+        {"calanemogust", CalDevice::ANEMO4403WindGust},
+        {"caluicpalrain", CalDevice::UICPALRainRate},
+        {"calrgrain", CalDevice::RG15RainRate},
+    };
+    // Reuse the cal command parser with dummy coefficients
+    CalibrateCommand calc = parseCalibrateCommand("cal " + sensor + " 1 0");
+    if (!calc.success) {
+        return -1;
+    }
+    auto it = channels.find(calc.command);
+    return it != channels.end() ? it->second : -1;
+}
+
+void commandCalibrateTableState(const String &name, const CalCoefficient &c) {
+    logConsoleMessage("[INFO] -----------------");
+    logConsoleMessage("[INFO] Calibration table");
+    logConsoleMessage("[INFO] -----------------");
+    logConsoleMessage("[INFO]  " + name + "- " + calCoeffAsString(c));
+    // Table alone, without the linear trim
+    CalCoefficient table = c;
+    table.a = 1;
+    table.b = 0;
+    for (int i = 0; i < c.points; i++) {
+        logConsoleMessage("[INFO]   x " + String(c.x[i], 4) + " -> y " + String(c.y[i], 4) + (c.fitted ? ", T(x) " + String(calibrate(c.x[i], table), 4) : ""));
+    }
+}
+
+void commandCalibrateTable(const std::string &msg) {
+    std::istringstream iss(msg);
+    std::vector<std::string> words;
+    std::string word;
+    while (iss >> word) {
+        std::transform(word.begin(), word.end(), word.begin(), ::tolower);
+        words.push_back(word);
+    }
+    if (words.size() < 3) {
+        logConsoleMessage("[CONSOLE] Sensor required, use command \"help cal\" please");
+        return;
+    }
+    bool point = words[1] == "point";
+    // Trailing values (point) or mode words (table) follow the sensor words
+    size_t sensorEnd = words.size();
+    if (point) {
+        sensorEnd = words.size() - 2;
+    } else {
+        for (size_t i = 2; i < words.size(); i++) {
+            if (words[i] == "linear" || words[i] == "piecewise" || words[i] == "poly") {
+                sensorEnd = i;
+                break;
+            }
+        }
+    }
+    std::string sensor;
+    for (size_t i = 2; i < sensorEnd; i++) {
+        sensor += words[i] + " ";
+    }
+    int channel = sensorEnd > 2 ? calChannel(sensor) : -1;
+    if (channel < 0) {
+        logConsoleMessage("[CONSOLE] Unknown calibration sensor, use command \"help cal\" please");
+        return;
+    }
+    CalCoefficient &c = calData[channel];
+    if (point) {
+        if (!addCalPoint(c, std::atof(words[sensorEnd].c_str()), std::atof(words[sensorEnd + 1].c_str()))) {
+            logConsoleMessage("[CONSOLE] Calibration table is full, " + String(CAL_TABLE_POINTS) + " points max");
+            return;
+        }
+        // First point of a linear channel starts a piecewise table
+        if (c.mode == CalMode::Linear) {
+            setCalMode(c, CalMode::Piecewise, c.degree);
+        }
+        saveCalPrefs();
+    } else if (sensorEnd < words.size()) {
+        if (words[sensorEnd] == "linear") {
+            setCalMode(c, CalMode::Linear, 1);
+        } else if (words[sensorEnd] == "piecewise") {
+            setCalMode(c, CalMode::Piecewise, c.degree);
+        } else {
+            int degree = sensorEnd + 1 < words.size() ? std::atoi(words[sensorEnd + 1].c_str()) : 2;
+            if (!setCalMode(c, CalMode::Polynomial, degree)) {
+                logConsoleMessage("[CONSOLE] Polynomial of degree " + String(c.degree) + " needs " + String(c.degree + 1) + " distinct points");
+            }
+        }
+        saveCalPrefs();
+    }
+    commandCalibrateTableState(String(sensor.c_str()), c);
+}
+
 void commandTempWeightState() {
     logConsoleMessage("[INFO] ------------------------");
     logConsoleMessage("[INFO] Temperature calc weights");
@@ -282,6 +575,947 @@ void commandHumiWeightState() {
     logConsoleMessage("[INFO]  AHT20  - " + String(H_NORM_WEIGHT_AHT20) + " [" + String(H_WEIGHT_AHT20) + "]");
 }
 
+void commandFusionState() {
+    SensorFusion *t = meteo.getTemperatureFusion();
+    SensorFusion *h = meteo.getHumidityFusion();
+    logConsoleMessage("[INFO] -------------------------------");
+    logConsoleMessage("[INFO] Temperature and humidity fusion");
+    logConsoleMessage("[INFO] -------------------------------");
+    logConsoleMessage("[INFO]  fusion - " + String(FUSION_ENABLED ? "on" : "off"));
+    const char *tNames[] = {"BMP280", "AHT20 ", "SHT45 "};
+    for (int i = 0; i < 3; i++) {
+        logConsoleMessage("[INFO]  T " + String(tNames[i]) + " - weight " + String(t->getWeight(i), 3) + ", noise " + String(sqrtf(t->getVariance(i)), 3) + "°C, bias " + String(t->getBias(i), 2) + "°C");
+    }
+    const char *hNames[] = {"AHT20 ", "SHT45 "};
+    for (int i = 0; i < 2; i++) {
+        logConsoleMessage("[INFO]  H " + String(hNames[i]) + " - weight " + String(h->getWeight(i), 3) + ", noise " + String(sqrtf(h->getVariance(i)), 3) + "%, bias " + String(h->getBias(i), 2) + "%");
+    }
+}
+
+void commandFusionOn() {
+    FUSION_ENABLED = 1;
+    saveSensorSettingsPrefs();
+    commandFusionState();
+}
+
+void commandFusionOff() {
+    FUSION_ENABLED = 0;
+    saveSensorSettingsPrefs();
+    commandFusionState();
+}
+
+String driftPairAsString(DriftPair *p, const char *unit) {
+    if (p->count == 0) {
+        return "n/a";
+    }
+    return String(p->mean, 2) + unit + " +/- " + String(sqrtf(p->variance), 2) + unit + (p->isReady() ? "" : " (warming up " + String(p->count) + "/" + String(DRIFT_WARMUP) + ")");
+}
+
+void commandDriftState() {
+    DriftDetector *d = meteo.getDrift();
+    logConsoleMessage("[INFO] ------------------");
+    logConsoleMessage("[INFO] Cross-sensor drift");
+    logConsoleMessage("[INFO] ------------------");
+    logConsoleMessage("[INFO] Mean residuals (thresholds " + String(DRIFT_TEMPERATURE_THRESHOLD, 1) + "°C, " + String(DRIFT_HUMIDITY_THRESHOLD, 1) + "%):");
+    logConsoleMessage("[INFO]   T BMP280-AHT20 - " + driftPairAsString(d->getTemperaturePair(0), "°C"));
+    logConsoleMessage("[INFO]   T BMP280-SHT45 - " + driftPairAsString(d->getTemperaturePair(1), "°C"));
+    logConsoleMessage("[INFO]   T AHT20-SHT45  - " + driftPairAsString(d->getTemperaturePair(2), "°C"));
+    logConsoleMessage("[INFO]   H AHT20-SHT45  - " + driftPairAsString(d->getHumidityPair(), "%"));
+    logConsoleMessage("[INFO] Drifting sensors and suggested calibration:");
+    bool any = false;
+    const char *tNames[] = {"BMP280", "AHT20", "SHT45"};
+    const char *tCommands[] = {"cal bmp temp", "cal aht temp", "cal sht temp"};
+    CalCoefficient tCal[] = {CAL_BMP280_TEMPERATURE, CAL_AHT20_TEMPERATURE, CAL_SHT45_TEMPERATURE};
+    for (int i = 0; i < 3; i++) {
+        if (d->isTemperatureDrifting(i)) {
+            float offset = d->getTemperatureOffset(i);
+            logConsoleMessage("[INFO]   " + String(tNames[i]) + " temperature " + String(offset, 2) + "°C - " + String(tCommands[i]) + " " + String(tCal[i].a, 4) + " " + String(tCal[i].b + offset, 4));
+            any = true;
+        }
+    }
+    const char *hNames[] = {"AHT20", "SHT45"};
+    const char *hCommands[] = {"cal aht humi", "cal sht humi"};
+    CalCoefficient hCal[] = {CAL_AHT20_HUMIDITY, CAL_SHT45_HUMIDITY};
+    for (int i = 0; i < 2; i++) {
+        if (d->isHumidityDrifting(i)) {
+            float offset = d->getHumidityOffset(i);
+            logConsoleMessage("[INFO]   " + String(hNames[i]) + " humidity " + String(offset, 2) + "% - " + String(hCommands[i]) + " " + String(hCal[i].a, 4) + " " + String(hCal[i].b + offset, 4));
+            any = true;
+        }
+    }
+    if (!any) {
+        logConsoleMessage("[INFO]   None");
+    }
+}
+
+void commandDriftReset() {
+    meteo.getDrift()->clear();
+    commandDriftState();
+}
+
+void commandQuantilesState() {
+    logConsoleMessage("[INFO] -----------------------");
+    logConsoleMessage("[INFO] Percentiles p10/p50/p90");
+    logConsoleMessage("[INFO] -----------------------");
+    logConsoleMessage("[INFO]  reset       - " + quantileResetAsString(observingconditions.getQuantileReset()));
+    logConsoleMessage("[INFO]  wind speed  - " + observingconditions.windspeed_q.asString(1) + " m/s (" + String(observingconditions.windspeed_q.getCount()) + " samples)");
+    logConsoleMessage("[INFO]  sky temp    - " + observingconditions.skytemp_q.asString(1) + " °C (" + String(observingconditions.skytemp_q.getCount()) + " samples)");
+    logConsoleMessage("[INFO]  sky quality - " + observingconditions.skyquality_q.asString(2) + " m/sas (" + String(observingconditions.skyquality_q.getCount()) + " samples)");
+}
+
+void commandQuantilesReset() {
+    observingconditions.requestQuantilesReset();
+    logConsoleMessage("[CONSOLE] Percentiles restart at the next update");
+}
+
+void commandShtState() {
+    logConsoleMessage("[INFO] ------------------------");
+    logConsoleMessage("[INFO] SHT45 precision settings");
+    logConsoleMessage("[INFO] ------------------------");
+    logConsoleMessage("[INFO]  precision    - " + meteo.getSht45()->precisionAsString(SHT45_PRECISION));
+    logConsoleMessage("[INFO]  oversampling - x" + String((int)SHT45_OVERSAMPLING));
+    logConsoleMessage("[INFO]  spread       - " + String(SHT45_SPREAD ? "on" : "off"));
+}
+
+void applyShtSettings() {
+    saveSensorSettingsPrefs();
+    if (HARDWARE_SHT45 && INITED_SHT45) {
+        meteo.getSht45()->setPrecision(SHT45_PRECISION, SHT45_OVERSAMPLING, SHT45_SPREAD);
+    }
+    commandShtState();
+}
+
+void commandShtPrecisionHigh() {
+    SHT45_PRECISION = SHT45Precision::High;
+    applyShtSettings();
+}
+
+void commandShtPrecisionMedium() {
+    SHT45_PRECISION = SHT45Precision::Medium;
+    applyShtSettings();
+}
+
+void commandShtPrecisionLow() {
+    SHT45_PRECISION = SHT45Precision::Low;
+    applyShtSettings();
+}
+
+void commandShtOversampling(unsigned long n) {
+    SHT45_OVERSAMPLING = constrain(n, 1UL, (unsigned long)SHT45_MAX_OVERSAMPLING);
+    applyShtSettings();
+}
+
+void commandShtSpreadOn() {
+    SHT45_SPREAD = 1;
+    applyShtSettings();
+}
+
+void commandShtSpreadOff() {
+    SHT45_SPREAD = 0;
+    applyShtSettings();
+}
+
+// Called from the SHT45 task once the report is measured
+void printShtReport(bool done) {
+    if (!done) {
+        logConsoleMessage("[CONSOLE] SHT45 heating active, try again later");
+        return;
+    }
+    SHT45AutoHeat *sht = meteo.getSht45();
+    logConsoleMessage("[INFO] ---------------------------------");
+    logConsoleMessage("[INFO] SHT45 precision report, " + String(SHT45_REPORT_SAMPLES) + " samples");
+    logConsoleMessage("[INFO] ---------------------------------");
+    for (int p = SHT45Precision::High; p <= SHT45Precision::Low; p++) {
+        SHT45Report r = sht->getReport(p);
+        logConsoleMessage("[INFO]  " + sht->precisionAsString(p) + " - noise T:" + String(r.temperatureNoise, 3) + "°C H:" + String(r.humidityNoise, 3) + "%, bus " + String(r.busMicros) + "us/measure, x" + String((int)SHT45_OVERSAMPLING) + " " + String(r.busMicros * (int)SHT45_OVERSAMPLING) + "us/reading");
+    }
+}
+
+void commandShtReport() {
+    if (!HARDWARE_SHT45 || !INITED_SHT45) {
+        logConsoleMessage("[CONSOLE] SHT45 not available");
+        return;
+    }
+    if (!meteo.requestSht45Report(printShtReport)) {
+        logConsoleMessage("[CONSOLE] SHT45 report already running");
+        return;
+    }
+    logConsoleMessage("[CONSOLE] SHT45 report started, " + String(SHT45_REPORT_SAMPLES) + " samples per precision");
+}
+
+void commandSkyState() {
+    logConsoleMessage("[INFO] ------------------------------");
+    logConsoleMessage("[INFO] Sky temperature noise settings");
+    logConsoleMessage("[INFO] ------------------------------");
+    logConsoleMessage("[INFO]  window   - " + String((int)SKY_NOISE_WINDOW) + " samples, " + String((int)SKY_NOISE_WINDOW * METEO_MEASURE_DELAY / 1000) + " sec");
+    logConsoleMessage("[INFO]  noise    - " + String(meteo.sensors.noise_db, 1) + " dB");
+    logConsoleMessage("[INFO]  snr      - " + String(meteo.sensors.snr_db, 1) + " dB");
+    logConsoleMessage("[INFO]  highrate - " + String(SKY_HIGH_RATE ? "on" : "off") + " (" + String(TURBULENCE_BAND_LOW, 1) + "-" + String(TURBULENCE_BAND_HIGH, 1) + " Hz band)");
+    logConsoleMessage("[INFO]  index    - " + String(meteo.sensors.turbulence, 1) + " dB");
+    String model = "";
+    for (int i = 1; i < SKY_MODEL_SIZE; i++) {
+        model += " " + String(skyModel[i], 2);
+    }
+    logConsoleMessage("[INFO]  model    -" + model);
+}
+
+void commandSkyHighRateOn() {
+    SKY_HIGH_RATE = 1;
+    saveSensorSettingsPrefs();
+    if (HARDWARE_MLX90614 && INITED_MLX90614) {
+        meteo.setSkyHighRate(true);
+    }
+    commandSkyState();
+}
+
+void commandSkyHighRateOff() {
+    SKY_HIGH_RATE = 0;
+    saveSensorSettingsPrefs();
+    meteo.setSkyHighRate(false);
+    commandSkyState();
+}
+
+void commandSkyModel(const float *k) {
+    for (int i = 1; i < SKY_MODEL_SIZE; i++) {
+        skyModel[i] = k[i - 1];
+    }
+    saveCalPrefs();
+    meteo.setSkyModel();
+    commandSkyState();
+}
+
+void commandSkyModelDefault() {
+    const float k[SKY_MODEL_SIZE - 1] = {33., 0., 4., 100., 100., 0., 0.};
+    commandSkyModel(k);
+}
+
+void commandSkyWindow(uint16_t n) {
+    SKY_NOISE_WINDOW = n;
+    saveSensorSettingsPrefs();
+    meteo.setSkyNoiseWindow(SKY_NOISE_WINDOW);
+    commandSkyState();
+}
+
+void commandBenchAnemo() {
+    if (!HARDWARE_ANEMO4403 || !INITED_ANEMO4403) {
+        logConsoleMessage("[CONSOLE] ANEMO4403 not available");
+        return;
+    }
+    const int runs = 1000;
+    const uint32_t windows[] = {300, METEO_MEASURE_DELAY, 20000};
+    PCNTFrequencyCounter *anm = meteo.getAnemo4403();
+    logConsoleMessage("[INFO] ---------------------------------");
+    logConsoleMessage("[INFO] ANEMO4403 window query, " + String(runs) + " runs");
+    logConsoleMessage("[INFO] ---------------------------------");
+    for (uint32_t window : windows) {
+        volatile uint64_t count = 0;
+        int64_t start = esp_timer_get_time();
+        for (int i = 0; i < runs; i++) {
+            count = anm->getCount(window);
+        }
+        float micros = (float)(esp_timer_get_time() - start) / runs;
+        logConsoleMessage("[INFO]  " + String(window) + "ms - " + String(micros, 2) + "us/query, count " + String((uint32_t)count));
+    }
+}
+
+void commandBenchSky() {
+    const int runs = 10;
+    float maxError = 0;
+    float errorSum = 0;
+    int evaluations = 0;
+    volatile float fsink = 0;
+    volatile double dsink = 0;
+    // Ambient -20..40°C, object -40..30°C
+    int64_t start = esp_timer_get_time();
+    for (int r = 0; r < runs; r++) {
+        for (float ta = -20; ta <= 40; ta += 0.5) {
+            for (float ts = -40; ts <= 30; ts += 1) {
+                fsink = meteo.tsky_calc(ts, ta);
+            }
+        }
+    }
+    int64_t fastMicros = esp_timer_get_time() - start;
+    start = esp_timer_get_time();
+    for (int r = 0; r < runs; r++) {
+        for (float ta = -20; ta <= 40; ta += 0.5) {
+            for (float ts = -40; ts <= 30; ts += 1) {
+                dsink = meteo.tsky_calc_ref(ts, ta);
+            }
+        }
+    }
+    int64_t refMicros = esp_timer_get_time() - start;
+    for (float ta = -20; ta <= 40; ta += 0.5) {
+        for (float ts = -40; ts <= 30; ts += 1) {
+            float error = fabs(meteo.tsky_calc(ts, ta) - meteo.tsky_calc_ref(ts, ta));
+            errorSum += error;
+            maxError = max(maxError, error);
+            evaluations++;
+        }
+    }
+    logConsoleMessage("[INFO] ------------------------------------");
+    logConsoleMessage("[INFO] Sky temperature model, " + String(evaluations * runs) + " evaluations");
+    logConsoleMessage("[INFO] ------------------------------------");
+    logConsoleMessage("[INFO]  float  - " + String((float)fastMicros / (evaluations * runs), 3) + "us/eval");
+    logConsoleMessage("[INFO]  double - " + String((float)refMicros / (evaluations * runs), 3) + "us/eval");
+    logConsoleMessage("[INFO]  error  - max " + String(maxError, 6) + "°C, mean " + String(errorSum / evaluations, 6) + "°C");
+}
+
+void commandBenchDew() {
+    const int runs = 10;
+    float maxDew = 0, maxFrost = 0, maxLinear = 0;
+    int evaluations = 0;
+    volatile float fsink = 0;
+    volatile double dsink = 0;
+    // Temperature -30..40°C, humidity 5..100%
+    int64_t start = esp_timer_get_time();
+    for (int r = 0; r < runs; r++) {
+        for (float t = -30; t <= 40; t += 1) {
+            for (float h = 5; h <= 100; h += 1) {
+                fsink = dewPoint(t, h);
+            }
+        }
+    }
+    int64_t fastMicros = esp_timer_get_time() - start;
+    start = esp_timer_get_time();
+    for (int r = 0; r < runs; r++) {
+        for (float t = -30; t <= 40; t += 1) {
+            for (float h = 5; h <= 100; h += 1) {
+                dsink = dewPointRef(t, h);
+            }
+        }
+    }
+    int64_t refMicros = esp_timer_get_time() - start;
+    for (float t = -30; t <= 40; t += 1) {
+        for (float h = 5; h <= 100; h += 1) {
+            double ref = dewPointRef(t, h);
+            maxDew = max(maxDew, (float)fabs(dewPoint(t, h) - ref));
+            maxFrost = max(maxFrost, (float)fabs(frostPoint(t, h) - frostPointRef(t, h)));
+            // Previous linear approximation, for comparison
+            maxLinear = max(maxLinear, (float)fabs(t - (100 - h) / 5. - ref));
+            evaluations++;
+        }
+    }
+    logConsoleMessage("[INFO] ------------------------------------");
+    logConsoleMessage("[INFO] Dew point, " + String(evaluations * runs) + " evaluations");
+    logConsoleMessage("[INFO] ------------------------------------");
+    logConsoleMessage("[INFO]  float  - " + String((float)fastMicros / (evaluations * runs), 3) + "us/eval");
+    logConsoleMessage("[INFO]  double - " + String((float)refMicros / (evaluations * runs), 3) + "us/eval");
+    logConsoleMessage("[INFO]  error  - dew max " + String(maxDew, 6) + "°C, frost max " + String(maxFrost, 6) + "°C");
+    logConsoleMessage("[INFO]  linear - max " + String(maxLinear, 2) + "°C (T - (100 - RH) / 5)");
+    logConsoleMessage("[INFO]  check  - 20°C/50% " + String(dewPoint(20, 50), 2) + "°C, 25°C/80% " + String(dewPoint(25, 80), 2) + "°C, -10°C/70% frost " + String(frostPoint(-10, 70), 2) + "°C");
+}
+
+// Buffer length of the former RunningAverage channels
+#define BENCH_OBSCON_SAMPLES 1200
+
+float benchObsconSamples[BENCH_OBSCON_SAMPLES];
+TimeSeries benchObsconSeries;
+unsigned long benchObsconNow;
+
+// Poller task of the obscon benchmark, reads the value as a getter would, without the request handling
+struct BenchObsconPoller {
+    int mode;
+    int runs;
+    int64_t micros;
+    SemaphoreHandle_t done;
+};
+
+float benchObsconQuery(int mode) {
+    if (mode == 0) {
+        // Linear pass as RunningAverage::getAverageLast did per request
+        float sum = 0;
+        for (int i = 0; i < BENCH_OBSCON_SAMPLES; i++) {
+            sum += benchObsconSamples[i];
+        }
+        return sum / BENCH_OBSCON_SAMPLES;
+    }
+    if (mode == 1) {
+        return benchObsconSeries.getMean(1800, benchObsconNow);
+    }
+    return observingconditions.averaged.temperature;
+}
+
+void benchObsconPollerTask(void *param) {
+    BenchObsconPoller *p = (BenchObsconPoller *)param;
+    volatile float sink = 0;
+    int64_t start = esp_timer_get_time();
+    for (int i = 0; i < p->runs; i++) {
+        sink = benchObsconQuery(p->mode);
+    }
+    p->micros = esp_timer_get_time() - start;
+    xSemaphoreGive(p->done);
+    vTaskDelete(NULL);
+}
+
+void commandBenchObscon() {
+    const int runs = 1000;
+    const int pollers[] = {1, 4};
+    const char *modes[] = {"1200 sample scan", "time bucket mean", "cached average  "};
+    // 4 hours of 3 s samples
+    for (int i = 0; i < BENCH_OBSCON_SAMPLES; i++) {
+        benchObsconSamples[i] = 20 + sinf(i / 100.);
+    }
+    benchObsconSeries.clear();
+    benchObsconNow = 0;
+    for (int i = 0; i < 4800; i++) {
+        benchObsconNow += 3000;
+        benchObsconSeries.add(20 + sinf(i / 100.), benchObsconNow);
+    }
+    // Refresh as update() does it, on the private series, the live ones belong to the workload task
+    volatile float sink = 0;
+    int64_t start = esp_timer_get_time();
+    for (int i = 0; i < runs; i++) {
+        for (int s = 0; s < OBSCON_SERIES; s++) {
+            sink = benchObsconSeries.getMean(1800, benchObsconNow);
+        }
+    }
+    float updateMicros = (float)(esp_timer_get_time() - start) / runs;
+    SemaphoreHandle_t done = xSemaphoreCreateCounting(4, 0);
+    logConsoleMessage("[INFO] ----------------------------------------------");
+    logConsoleMessage("[INFO] Alpaca average lookup, " + String(runs) + " queries per poller");
+    logConsoleMessage("[INFO] ----------------------------------------------");
+    logConsoleMessage("[INFO]  Pollers are tasks reading the value, not timed alpaca requests");
+    for (int mode = 0; mode < 3; mode++) {
+        for (int n : pollers) {
+            BenchObsconPoller p[4];
+            for (int k = 0; k < n; k++) {
+                p[k] = {mode, runs, 0, done};
+                xTaskCreate(benchObsconPollerTask, "benchObscon", 2048, &p[k], 1, NULL);
+            }
+            int64_t total = 0;
+            for (int k = 0; k < n; k++) {
+                xSemaphoreTake(done, portMAX_DELAY);
+            }
+            for (int k = 0; k < n; k++) {
+                total += p[k].micros;
+            }
+            logConsoleMessage("[INFO]  " + String(modes[mode]) + " - " + String((float)total / (n * runs), 3) + "us/query, " + String(n) + " poller(s)");
+        }
+    }
+    vSemaphoreDelete(done);
+    logConsoleMessage("[INFO]  refresh of " + String(OBSCON_SERIES) + " 30 min means - " + String(updateMicros, 2) + "us/update");
+}
+
+String historyTimeAsString(uint32_t time, const char *format = "%H:%M:%S") {
+    if (time <= NTP_TIME_VALID) {
+        return String(time) + "s";
+    }
+    time_t t = time;
+    struct tm timeinfo;
+    localtime_r(&t, &timeinfo);
+    char buf[32];
+    strftime(buf, sizeof(buf), format, &timeinfo);
+    return String(buf);
+}
+
+void commandHistoryState() {
+    logConsoleMessage("[INFO] --------------");
+    logConsoleMessage("[INFO] Sensor history");
+    logConsoleMessage("[INFO] --------------");
+    if (!history.isReady()) {
+        logConsoleMessage("[INFO]  disabled - PSRAM not available");
+        return;
+    }
+    uint32_t records = history.getRecords();
+    uint32_t used = history.getUsed();
+    logConsoleMessage("[INFO]  memory   - " + String(used / 1024) + "/" + String(history.getCapacity() / 1024) + " KB PSRAM");
+    logConsoleMessage("[INFO]  records  - " + String(records) + " x " + String(HISTORY_CHANNELS) + " channels");
+    if (records > 0) {
+        float perRecord = (float)used / records;
+        logConsoleMessage("[INFO]  record   - " + String(perRecord, 1) + " bytes, raw " + String((HISTORY_CHANNELS + 1) * 4) + " bytes");
+        logConsoleMessage("[INFO]  span     - " + historyTimeAsString(history.getOldest(), "%Y-%m-%d %H:%M:%S") + " .. " + historyTimeAsString(history.getNewest(), "%Y-%m-%d %H:%M:%S"));
+        logConsoleMessage("[INFO]  capacity - ~" + String(history.getCapacity() / perRecord * METEO_MEASURE_DELAY / 3600000., 1) + " hours");
+    }
+}
+
+void commandHistoryChannels() {
+    logConsoleMessage("[INFO] ----------------");
+    logConsoleMessage("[INFO] History channels");
+    logConsoleMessage("[INFO] ----------------");
+    for (int i = 0; i < HISTORY_CHANNELS; i++) {
+        logConsoleMessage("[INFO]  " + String(historyChannelName(i)) + " - " + String(historyChannelDecimals(i)) + " decimals");
+    }
+}
+
+void commandHistory(const std::string &msg) {
+    std::istringstream iss(msg);
+    std::string word, name, at;
+    int minutes = 10;
+    iss >> word >> name;
+    int channel = historyChannelFromString(String(name.c_str()));
+    if (channel < 0) {
+        logConsoleMessage("[CONSOLE] Unknown history channel, use command \"history channels\" please");
+        return;
+    }
+    if (!history.isReady()) {
+        logConsoleMessage("[CONSOLE] History disabled, PSRAM not available");
+        return;
+    }
+    if (iss >> word) {
+        if (word.find(':') != std::string::npos) {
+            at = word;
+            iss >> minutes;
+        } else {
+            minutes = atoi(word.c_str());
+        }
+    }
+    minutes = max(minutes, 1);
+    uint32_t now = historyTime();
+    uint32_t from = now - minutes * 60;
+    if (!at.empty()) {
+        if (now <= NTP_TIME_VALID) {
+            logConsoleMessage("[CONSOLE] Clock not set, use the last minutes form please");
+            return;
+        }
+        // Today's hh:mm, yesterday's if still ahead
+        time_t t = now;
+        struct tm timeinfo;
+        localtime_r(&t, &timeinfo);
+        timeinfo.tm_hour = atoi(at.c_str());
+        timeinfo.tm_min = atoi(at.c_str() + at.find(':') + 1);
+        timeinfo.tm_sec = 0;
+        from = mktime(&timeinfo);
+        if (from > now) {
+            from -= 86400;
+        }
+    }
+    uint32_t to = from + minutes * 60;
+    // Values reduced to equal time bins for the console
+    struct {
+        float sum, min, max;
+        uint16_t count;
+    } bins[HISTORY_CONSOLE_LINES] = {};
+    uint32_t span = to - from + 1;
+    history.query(channel, from, to, [&](uint32_t time, float value) {
+        if (std::isnan(value)) {
+            return;
+        }
+        auto &b = bins[(uint64_t)(time - from) * HISTORY_CONSOLE_LINES / span];
+        b.min = b.count ? min(b.min, value) : value;
+        b.max = b.count ? max(b.max, value) : value;
+        b.sum += value;
+        b.count++;
+    });
+    int decimals = historyChannelDecimals(channel);
+    String title = String(historyChannelName(channel)) + " " + historyTimeAsString(from, "%H:%M") + ", " + String(minutes) + " min";
+    String line = "";
+    for (unsigned int i = 0; i < title.length(); i++) {
+        line += "-";
+    }
+    logConsoleMessage("[INFO] " + line);
+    logConsoleMessage("[INFO] " + title);
+    logConsoleMessage("[INFO] " + line);
+    bool any = false;
+    for (int i = 0; i < HISTORY_CONSOLE_LINES; i++) {
+        if (bins[i].count == 0) {
+            continue;
+        }
+        uint32_t start = from + (uint64_t)i * span / HISTORY_CONSOLE_LINES;
+        String values = String(bins[i].sum / bins[i].count, decimals);
+        if (bins[i].count > 1) {
+            values += " (" + String(bins[i].min, decimals) + ".." + String(bins[i].max, decimals) + ", " + String(bins[i].count) + " samples)";
+        }
+        logConsoleMessage("[INFO]  " + historyTimeAsString(start) + " - " + values);
+        any = true;
+    }
+    if (!any) {
+        logConsoleMessage("[INFO]  No records");
+    }
+}
+
+void commandBenchHistory() {
+    const int records = 1000;
+    const uint32_t blocks = 24;
+    uint8_t *storage = (uint8_t *)malloc(blocks * HISTORY_BLOCK_SIZE);
+    if (!storage) {
+        logConsoleMessage("[CONSOLE] Not enough memory for the benchmark store");
+        return;
+    }
+    // Scratch store fed with the latest recorded values plus a slow drift and noise
+    float latest[HISTORY_CHANNELS] = {0};
+    uint32_t newest = history.getNewest();
+    for (int i = 0; i < HISTORY_CHANNELS; i++) {
+        history.query(i, newest, newest, [&](uint32_t, float value) { latest[i] = std::isnan(value) ? 0 : value; });
+    }
+    HistoryStore scratch;
+    scratch.begin(storage, blocks);
+    float values[HISTORY_CHANNELS];
+    int64_t start = esp_timer_get_time();
+    for (int r = 0; r < records; r++) {
+        for (int i = 0; i < HISTORY_CHANNELS; i++) {
+            values[i] = latest[i] + 0.5 * sinf(r / 200.) + 0.01 * (esp_random() % 5);
+        }
+        scratch.add(1000000 + r * METEO_MEASURE_DELAY / 1000, values);
+    }
+    float appendMicros = (float)(esp_timer_get_time() - start) / records;
+    float perRecord = (float)scratch.getUsed() / scratch.getRecords();
+    uint32_t decoded = 0;
+    start = esp_timer_get_time();
+    for (int i = 0; i < HISTORY_CHANNELS; i++) {
+        decoded += scratch.query(i, 0, UINT32_MAX, [](uint32_t, float) {});
+    }
+    float scratchQuery = (float)(esp_timer_get_time() - start) / decoded;
+    logConsoleMessage("[INFO] -------------------------------------");
+    logConsoleMessage("[INFO] History store, " + String(records) + " synthetic records");
+    logConsoleMessage("[INFO] -------------------------------------");
+    logConsoleMessage("[INFO]  append   - " + String(appendMicros, 2) + "us/record");
+    logConsoleMessage("[INFO]  record   - " + String(perRecord, 1) + " bytes, raw " + String((HISTORY_CHANNELS + 1) * 4) + " bytes, x" + String((HISTORY_CHANNELS + 1) * 4 / perRecord, 1));
+    logConsoleMessage("[INFO]  query    - " + String(scratchQuery, 3) + "us/record, " + String(1 / scratchQuery, 2) + "M records/s");
+    free(storage);
+    if (history.isReady() && history.getRecords() > 0) {
+        start = esp_timer_get_time();
+        decoded = history.query(HistoryChannel::Temperature, 0, UINT32_MAX, [](uint32_t, float) {});
+        float liveQuery = (float)(esp_timer_get_time() - start) / max(decoded, (uint32_t)1);
+        logConsoleMessage("[INFO]  live     - " + String(decoded) + " records, " + String(liveQuery, 3) + "us/record (PSRAM), " + String((float)history.getUsed() / history.getRecords(), 1) + " bytes/record");
+    }
+}
+
+void commandTsLogState() {
+    logConsoleMessage("[INFO] ---------");
+    logConsoleMessage("[INFO] Flash log");
+    logConsoleMessage("[INFO] ---------");
+    if (!tslog.isReady()) {
+        logConsoleMessage("[INFO]  disabled - partition \"" TSLOG_PARTITION "\" not found");
+        return;
+    }
+    uint32_t records = tslog.getRecords();
+    TsLogCounters c = tslog.getCounters();
+    logConsoleMessage("[INFO]  partition - " + String(tslog.getSectors()) + " x " + String(TSLOG_SECTOR / 1024) + " KB sectors, " + String(TSLOG_RECORDS) + " records each");
+    logConsoleMessage("[INFO]  capacity  - ~" + String((float)(tslog.getSectors() - 1) * TSLOG_RECORDS * TSLOG_PERIOD / 86400, 1) + " days of " + String(TSLOG_PERIOD) + "s records");
+    logConsoleMessage("[INFO]  retention - " + (tslog.getRetention() ? String(tslog.getRetention()) + " days" : String("all")));
+    logConsoleMessage("[INFO]  records   - " + String(records));
+    if (records > 0) {
+        logConsoleMessage("[INFO]  span      - " + historyTimeAsString(tslog.getOldest(), "%Y-%m-%d %H:%M") + " .. " + historyTimeAsString(tslog.getNewest(), "%Y-%m-%d %H:%M"));
+    }
+    if (c.logical > 0) {
+        logConsoleMessage("[INFO]  written   - " + String(c.written) + " bytes for " + String(c.logical) + " bytes of records, " + String(c.erased / TSLOG_SECTOR) + " erases since boot");
+    }
+}
+
+void commandTsLogRetention(uint16_t days) {
+    tslog.setRetention(days);
+    saveTsLogPrefs();
+    commandTsLogState();
+}
+
+void commandTsLogFormat() {
+    tslog.format();
+    commandTsLogState();
+}
+
+void commandTsLog(const std::string &msg) {
+    std::istringstream iss(msg);
+    std::string word, name;
+    int hours = 24;
+    iss >> word >> name;
+    int channel = tslogChannelFromString(String(name.c_str()));
+    if (channel < 0) {
+        logConsoleMessage("[CONSOLE] Unknown flash log channel, use command \"history channels\" please, flash log keeps:");
+        String names = "";
+        for (int i = 0; i < TSLOG_CHANNELS; i++) {
+            names += String(i ? ", " : "") + tslogChannelName(i);
+        }
+        logConsoleMessage("[CONSOLE] " + names);
+        return;
+    }
+    if (!tslog.isReady()) {
+        logConsoleMessage("[CONSOLE] Flash log disabled, partition not found");
+        return;
+    }
+    iss >> hours;
+    hours = max(hours, 1);
+    uint32_t to = historyTime();
+    uint32_t from = to - hours * 3600;
+    int decimals = tslogChannelDecimals(channel);
+    float lo, hi, mean;
+    uint32_t count = tslog.summarize(channel, from, to, &lo, &hi, &mean);
+    String title = String(tslogChannelName(channel)) + ", " + String(hours) + " hours";
+    String line = "";
+    for (unsigned int i = 0; i < title.length(); i++) {
+        line += "-";
+    }
+    logConsoleMessage("[INFO] " + line);
+    logConsoleMessage("[INFO] " + title);
+    logConsoleMessage("[INFO] " + line);
+    if (count == 0) {
+        logConsoleMessage("[INFO]  No records");
+        return;
+    }
+    logConsoleMessage("[INFO]  all - " + String(mean, decimals) + " (" + String(lo, decimals) + ".." + String(hi, decimals) + ", " + String(count) + " minutes)");
+    int bins = min(hours, HISTORY_CONSOLE_LINES);
+    uint32_t span = to - from;
+    for (int i = 0; i < bins; i++) {
+        uint32_t start = from + (uint64_t)i * span / bins;
+        uint32_t end = from + (uint64_t)(i + 1) * span / bins - 1;
+        count = tslog.summarize(channel, start, end, &lo, &hi, &mean);
+        if (count > 0) {
+            logConsoleMessage("[INFO]  " + historyTimeAsString(start, "%m-%d %H:%M") + " - " + String(mean, decimals) + " (" + String(lo, decimals) + ".." + String(hi, decimals) + ")");
+        }
+    }
+}
+
+void commandBenchTsLog() {
+    // Simulated partition, a long run wraps it a few times
+    uint32_t sectors = psramFound() ? 64 : 16;
+    uint8_t *storage = (uint8_t *)(psramFound() ? ps_malloc(sectors * TSLOG_SECTOR) : malloc(sectors * TSLOG_SECTOR));
+    if (!storage) {
+        logConsoleMessage("[CONSOLE] Not enough memory for the simulated partition");
+        return;
+    }
+    TsLogRamFlash flash(storage, sectors * TSLOG_SECTOR);
+    TsLog scratch;
+    scratch.setRetention(0);
+    scratch.begin(&flash);
+    scratch.format();
+    scratch.resetCounters();
+    const uint32_t records = sectors * TSLOG_RECORDS * 3;
+    const uint32_t t0 = 1700000000;
+    TsLogRecord r;
+    int64_t start = esp_timer_get_time();
+    for (uint32_t i = 0; i < records; i++) {
+        r.time = t0 + i * TSLOG_PERIOD;
+        r.samples = TSLOG_PERIOD * 1000 / METEO_MEASURE_DELAY;
+        for (int c = 0; c < TSLOG_CHANNELS; c++) {
+            r.values[c] = tslogQuantize(10 + c + 5 * sinf(i / 500. + c), c);
+        }
+        scratch.append(r);
+    }
+    float appendMicros = (float)(esp_timer_get_time() - start) / records;
+    TsLogCounters w = scratch.getCounters();
+    uint32_t newest = t0 + (records - 1) * TSLOG_PERIOD;
+    uint32_t from = newest - (sectors / 2) * TSLOG_RECORDS * TSLOG_PERIOD;
+    float lo, hi, mean;
+    scratch.resetCounters();
+    start = esp_timer_get_time();
+    uint32_t scanned = scratch.query(0, from, newest, [](uint32_t, float) {});
+    float queryMicros = (float)(esp_timer_get_time() - start);
+    uint32_t queryRead = scratch.getCounters().read;
+    scratch.resetCounters();
+    start = esp_timer_get_time();
+    scratch.summarize(0, from, newest, &lo, &hi, &mean);
+    float summaryMicros = (float)(esp_timer_get_time() - start);
+    TsLogCounters s = scratch.getCounters();
+    free(storage);
+    logConsoleMessage("[INFO] ----------------------------------");
+    logConsoleMessage("[INFO] Flash log on a simulated partition");
+    logConsoleMessage("[INFO] ----------------------------------");
+    logConsoleMessage("[INFO]  size      - " + String(sectors) + " sectors, " + String(records) + " records appended");
+    logConsoleMessage("[INFO]  append    - " + String(appendMicros, 2) + "us/record (RAM)");
+    logConsoleMessage("[INFO]  write amp - x" + String((float)w.written / w.logical, 3) + " programmed, x" + String((float)(w.written + w.erased) / w.logical, 3) + " with erases");
+    logConsoleMessage("[INFO]  scan      - " + String(scanned) + " records, " + String(queryMicros / 1000, 2) + "ms, " + String(queryRead / 1024) + " KB read");
+    logConsoleMessage("[INFO]  summary   - " + String(summaryMicros / 1000, 2) + "ms, " + String(s.read / 1024) + " KB read, " + String(s.skipped) + " sectors from summaries");
+    if (tslog.isReady()) {
+        start = esp_timer_get_time();
+        uint32_t count = tslog.summarize(0, 0, UINT32_MAX, &lo, &hi, &mean);
+        logConsoleMessage("[INFO]  partition - " + String(count) + " records summarized in " + String((esp_timer_get_time() - start) / 1000., 2) + "ms (flash)");
+    }
+}
+
+// Seconds of a duration like 30m, 12h or 7d, hours without a unit
+uint32_t parseDuration(const std::string &word) {
+    uint32_t value = atoi(word.c_str());
+    switch (word.empty() ? 'h' : tolower(word.back())) {
+    case 'm':
+        return value * 60;
+    case 'd':
+        return value * 86400;
+    }
+    return value * 3600;
+}
+
+String durationAsString(uint32_t seconds) {
+    if (seconds % 86400 == 0) {
+        return String(seconds / 86400) + "d";
+    }
+    if (seconds % 3600 == 0) {
+        return String(seconds / 3600) + "h";
+    }
+    return String(seconds / 60) + "m";
+}
+
+void commandRollupState() {
+    logConsoleMessage("[INFO] ------------");
+    logConsoleMessage("[INFO] Rollup tiers");
+    logConsoleMessage("[INFO] ------------");
+    if (!rollups.isReady()) {
+        logConsoleMessage("[INFO]  disabled - PSRAM not available");
+        return;
+    }
+    for (int i = 0; i < ROLLUP_TIERS; i++) {
+        RollupTier *tier = rollups.getTier(i);
+        uint32_t oldest = tier->getOldest();
+        logConsoleMessage("[INFO]  " + durationAsString(tier->getSeconds()) + " - " + String(tier->getMemory() / 1024) + " KB, held from " + (oldest ? historyTimeAsString(oldest, "%Y-%m-%d %H:%M") : String("start")));
+    }
+}
+
+void commandRollup(const std::string &msg) {
+    std::istringstream iss(msg);
+    std::string word, name, range, resolution;
+    iss >> word >> name >> range >> resolution;
+    int channel = tslogChannelFromString(String(name.c_str()));
+    if (channel < 0 || range.empty()) {
+        logConsoleMessage("[CONSOLE] Unknown rollup channel or range, use command \"help info\" please");
+        return;
+    }
+    if (!rollups.isReady()) {
+        logConsoleMessage("[CONSOLE] Rollups disabled, PSRAM not available");
+        return;
+    }
+    uint32_t to = historyTime();
+    uint32_t span = max(parseDuration(range), (uint32_t)60);
+    uint32_t from = to - span;
+    int decimals = tslogChannelDecimals(channel);
+    RollupResult all = rollups.summarize(channel, from, to);
+    String title = String(tslogChannelName(channel)) + ", last " + durationAsString(span);
+    String line = "";
+    for (unsigned int i = 0; i < title.length(); i++) {
+        line += "-";
+    }
+    logConsoleMessage("[INFO] " + line);
+    logConsoleMessage("[INFO] " + title);
+    logConsoleMessage("[INFO] " + line);
+    if (all.count == 0) {
+        logConsoleMessage("[INFO]  No records");
+        return;
+    }
+    logConsoleMessage("[INFO]  all - " + String(all.mean, decimals) + " (" + String(all.min, decimals) + ".." + String(all.max, decimals) + ", " + String(all.count) + " minutes, " + String(all.buckets) + " buckets)");
+    if (!resolution.empty()) {
+        uint32_t step = max(parseDuration(resolution), (uint32_t)60);
+        // Last lines of the console limit
+        if (span / step > HISTORY_CONSOLE_LINES) {
+            from = to - HISTORY_CONSOLE_LINES * step;
+        }
+        rollups.query(channel, from, to, step, [&](uint32_t start, const RollupResult &r) {
+            logConsoleMessage("[INFO]  " + historyTimeAsString(start, "%m-%d %H:%M") + " - " + String(r.mean, decimals) + " (" + String(r.min, decimals) + ".." + String(r.max, decimals) + ")");
+        });
+    }
+}
+
+void commandWarmStartState() {
+    int32_t age = getWarmStartAge();
+    int32_t restored = getWarmStartRestored();
+    logConsoleMessage("[INFO] ----------");
+    logConsoleMessage("[INFO] Warm start");
+    logConsoleMessage("[INFO] ----------");
+    logConsoleMessage("[INFO]  max age    - " + (getWarmStartMaxAge() ? String(getWarmStartMaxAge()) + "s" : String("off")));
+    logConsoleMessage("[INFO]  boot       - " + (restored >= 0 ? "restored " + String(restored) + "s old state" : String("cold start")));
+    logConsoleMessage("[INFO]  checkpoint - " + (age >= 0 ? String(age) + "s old, " + String(sizeof(WarmStartState)) + " bytes RTC memory" : String("none")));
+}
+
+void commandWarmStartAge(uint16_t seconds) {
+    setWarmStartMaxAge(seconds);
+    saveWarmStartPrefs();
+    commandWarmStartState();
+}
+
+void commandTrendState() {
+    logConsoleMessage("[INFO] ------");
+    logConsoleMessage("[INFO] Trends");
+    logConsoleMessage("[INFO] ------");
+    for (int i = 0; i < TREND_CHANNELS; i++) {
+        SlidingRegression *trend = meteo.getTrend(i);
+        String line = "[INFO]  " + String(trendChannelName(i)) + " -";
+        for (uint8_t w = 0; w < TREND_WINDOWS; w++) {
+            float slope = trend->getSlope(w) * 3600;
+            line += " " + durationAsString(trend->getWindow(w)) + " " + (std::isnan(slope) ? String("n/a") : String(slope, 3) + "/h");
+            line += " (" + String(trend->getCount(w)) + " samples, " + String(100 * trend->getCoverage(w), 0) + "%)";
+        }
+        logConsoleMessage(line);
+    }
+    logConsoleMessage("[INFO]  tendency - " + String(meteo.sensors.pressure_tendency_1h, 2) + " hPa/1h, " + String(meteo.sensors.pressure_tendency_3h, 2) + " hPa/3h");
+}
+
+void commandBenchTrend() {
+    const int samples = 3 * 3600;
+    const int runs = 100;
+    float *buffer = (float *)malloc(samples * sizeof(float));
+    if (!buffer) {
+        logConsoleMessage("[CONSOLE] Not enough memory for the benchmark buffer");
+        return;
+    }
+    // 3 hours of 1 s pressure samples, the sliding regression is fed as Meteo does
+    SlidingRegression *scratch = new SlidingRegression();
+    volatile float sink = 0;
+    int64_t start = esp_timer_get_time();
+    for (int i = 0; i < samples; i++) {
+        buffer[i] = 1013 - i / 3600.f + 0.2f * sinf(i / 300.f);
+        scratch->add(buffer[i], i * 1000UL);
+        sink = scratch->getSlope(TrendWindow::ThreeHours);
+    }
+    float slidingMicros = (float)(esp_timer_get_time() - start) / samples;
+    // Least squares over the whole buffer per update
+    double slope = 0;
+    start = esp_timer_get_time();
+    for (int r = 0; r < runs; r++) {
+        double n = samples, st = 0, sy = 0, stt = 0, sty = 0;
+        for (int i = 0; i < samples; i++) {
+            st += i;
+            sy += buffer[i];
+            stt += (double)i * i;
+            sty += (double)i * buffer[i];
+        }
+        slope = (n * sty - st * sy) / (n * stt - st * st);
+    }
+    float rescanMicros = (float)(esp_timer_get_time() - start) / runs;
+    logConsoleMessage("[INFO] -----------------------------------------");
+    logConsoleMessage("[INFO] Pressure tendency, 3 hours of 1 s samples");
+    logConsoleMessage("[INFO] -----------------------------------------");
+    logConsoleMessage("[INFO]  sliding - " + String(slidingMicros, 2) + "us/update, " + String(sizeof(SlidingRegression)) + " bytes, " + String(scratch->getSlope(TrendWindow::ThreeHours) * 10800, 3) + " hPa/3h");
+    logConsoleMessage("[INFO]  rescan  - " + String(rescanMicros, 0) + "us/update, " + String(samples * sizeof(float)) + " bytes, " + String(slope * 10800, 3) + " hPa/3h");
+    delete scratch;
+    free(buffer);
+}
+
+void commandBenchRollup() {
+    const int runs = 100;
+    uint8_t *storage = psramFound() ? (uint8_t *)ps_malloc(Rollups::getMemoryNeeded()) : nullptr;
+    if (!storage) {
+        logConsoleMessage("[CONSOLE] Not enough PSRAM for the benchmark rollups");
+        return;
+    }
+    // 31 days of synthetic minutes
+    Rollups scratch;
+    scratch.begin(storage);
+    const uint32_t minutes = 31 * 1440;
+    const uint32_t t0 = 1700000000 / 86400 * 86400;
+    TsLogRecord r;
+    int64_t start = esp_timer_get_time();
+    for (uint32_t i = 0; i < minutes; i++) {
+        r.time = t0 + i * 60;
+        for (int c = 0; c < TSLOG_CHANNELS; c++) {
+            r.values[c] = tslogQuantize(10 + c + 5 * sinf(i / 500. + c), c);
+        }
+        scratch.add(r);
+    }
+    float addMicros = (float)(esp_timer_get_time() - start) / minutes;
+    uint32_t end = t0 + minutes * 60;
+    const struct {
+        const char *name;
+        uint32_t span;
+        uint32_t resolution;
+    } cases[] = {
+        {"max 1h ", 3600, 3600},
+        {"max 24h", 86400, 86400},
+        {"max 7d ", 7 * 86400, 7 * 86400},
+        {"30d x1d", 30 * 86400, 86400},
+        {"7d x1h ", 7 * 86400, 3600}};
+    logConsoleMessage("[INFO] ------------------------------------------");
+    logConsoleMessage("[INFO] Rollup queries over 31 days of minutes, " + String(runs) + " runs");
+    logConsoleMessage("[INFO] ------------------------------------------");
+    logConsoleMessage("[INFO]  add     - " + String(addMicros, 2) + "us/minute, " + String(Rollups::getMemoryNeeded() / 1024) + " KB PSRAM");
+    for (auto &c : cases) {
+        uint32_t buckets = 0, answered = 0;
+        start = esp_timer_get_time();
+        for (int i = 0; i < runs; i++) {
+            buckets = 0;
+            answered = scratch.query(TSLOG_CHANNELS - 1, end - c.span, end, c.resolution, [&](uint32_t, const RollupResult &res) { buckets += res.buckets; });
+        }
+        float micros = (float)(esp_timer_get_time() - start) / runs;
+        logConsoleMessage("[INFO]  " + String(c.name) + " - " + String(micros, 1) + "us, " + String(answered) + " answers from " + String(buckets) + " buckets, minute scan " + String(c.span / 60) + " records");
+    }
+    free(storage);
+}
+
 void commandUptime() {
     logConsoleMessage("[INFO] ------------");
     logConsoleMessage("[INFO] Uptime");
@@ -311,122 +1545,122 @@ void commandReboot() {
 }
 
 void commandCalibrateBMP280Temperature(float a, float b) {
-    CalCoefficient c(a, b);
-    CAL_BMP280_TEMPERATURE = c;
+    CAL_BMP280_TEMPERATURE.a = a;
+    CAL_BMP280_TEMPERATURE.b = b;
     saveCalPrefs();
 }
 
 void commandCalibrateBMP280Pressure(float a, float b) {
-    CalCoefficient c(a, b);
-    CAL_BMP280_PRESSURE = c;
+    CAL_BMP280_PRESSURE.a = a;
+    CAL_BMP280_PRESSURE.b = b;
     saveCalPrefs();
 }
 
 void commandCalibrateAHT20Temperature(float a, float b) {
-    CalCoefficient c(a, b);
-    CAL_AHT20_TEMPERATURE = c;
+    CAL_AHT20_TEMPERATURE.a = a;
+    CAL_AHT20_TEMPERATURE.b = b;
     saveCalPrefs();
 }
 
 void commandCalibrateAHT20Humidity(float a, float b) {
-    CalCoefficient c(a, b);
-    CAL_AHT20_HUMIDITY = c;
+    CAL_AHT20_HUMIDITY.a = a;
+    CAL_AHT20_HUMIDITY.b = b;
     saveCalPrefs();
 }
 
 void commandCalibrateSHT45Temperature(float a, float b) {
-    CalCoefficient c(a, b);
-    CAL_SHT45_TEMPERATURE = c;
+    CAL_SHT45_TEMPERATURE.a = a;
+    CAL_SHT45_TEMPERATURE.b = b;
     saveCalPrefs();
 }
 
 void commandCalibrateSHT45Humidity(float a, float b) {
-    CalCoefficient c(a, b);
-    CAL_SHT45_TEMPERATURE = c;
+    CAL_SHT45_HUMIDITY.a = a;
+    CAL_SHT45_HUMIDITY.b = b;
     saveCalPrefs();
 }
 
 void commandCalibrateDewPoint(float a, float b) {
-    CalCoefficient c(a, b);
-    CAL_DEW_POINT = c;
+    CAL_DEW_POINT.a = a;
+    CAL_DEW_POINT.b = b;
     saveCalPrefs();
 }
 
 void commandCalibrateTemperature(float a, float b) {
-    CalCoefficient c(a, b);
-    CAL_TEMPERATURE = c;
+    CAL_TEMPERATURE.a = a;
+    CAL_TEMPERATURE.b = b;
     saveCalPrefs();
 }
 
 void commandCalibrateHumidity(float a, float b) {
-    CalCoefficient c(a, b);
-    CAL_HUMIDITY = c;
+    CAL_HUMIDITY.a = a;
+    CAL_HUMIDITY.b = b;
     saveCalPrefs();
 }
 
 void commandCalibrateRainRate(float a, float b) {
-    CalCoefficient c(a, b);
-    CAL_RAIN_RATE = c;
+    CAL_RAIN_RATE.a = a;
+    CAL_RAIN_RATE.b = b;
     saveCalPrefs();
 }
 
 void commandCalibrateMLX90614Ambient(float a, float b) {
-    CalCoefficient c(a, b);
-    CAL_MLX90614_AMBIENT = c;
+    CAL_MLX90614_AMBIENT.a = a;
+    CAL_MLX90614_AMBIENT.b = b;
     saveCalPrefs();
 }
 
 void commandCalibrateMLX90614Object(float a, float b) {
-    CalCoefficient c(a, b);
-    CAL_MLX90614_OBJECT = c;
+    CAL_MLX90614_OBJECT.a = a;
+    CAL_MLX90614_OBJECT.b = b;
     saveCalPrefs();
 }
 
 void commandCalibrateMLX90614SkyTemperature(float a, float b) {
-    CalCoefficient c(a, b);
-    CAL_MLX90614_SKYTEMP = c;
+    CAL_MLX90614_SKYTEMP.a = a;
+    CAL_MLX90614_SKYTEMP.b = b;
     saveCalPrefs();
 }
 
 void commandCalibrateMLX90614CloudCover(float a, float b) {
-    CalCoefficient c(a, b);
-    CAL_MLX90614_CLOUDCOVER = c;
+    CAL_MLX90614_CLOUDCOVER.a = a;
+    CAL_MLX90614_CLOUDCOVER.b = b;
     saveCalPrefs();
 }
 
 void commandCalibrateTSL2591SkyBrightness(float a, float b) {
-    CalCoefficient c(a, b);
-    CAL_TSL2591_SKYBRIGHTNESS = c;
+    CAL_TSL2591_SKYBRIGHTNESS.a = a;
+    CAL_TSL2591_SKYBRIGHTNESS.b = b;
     saveCalPrefs();
 }
 
 void commandCalibrateTSL2591SkyQuality(float a, float b) {
-    CalCoefficient c(a, b);
-    CAL_TSL2591_SKYQUALITY = c;
+    CAL_TSL2591_SKYQUALITY.a = a;
+    CAL_TSL2591_SKYQUALITY.b = b;
     saveCalPrefs();
 }
 
 void commandCalibrateANEMO4403WindSpeed(float a, float b) {
-    CalCoefficient c(a, b);
-    CAL_ANEMO4403_WINDSPEED = c;
+    CAL_ANEMO4403_WINDSPEED.a = a;
+    CAL_ANEMO4403_WINDSPEED.b = b;
     saveCalPrefs();
 }
 
 void commandCalibrateANEMO4403WindGust(float a, float b) {
-    CalCoefficient c(a, b);
-    CAL_ANEMO4403_WINDGUST = c;
+    CAL_ANEMO4403_WINDGUST.a = a;
+    CAL_ANEMO4403_WINDGUST.b = b;
     saveCalPrefs();
 }
 
 void commandCalibrateUICPALRainRate(float a, float b) {
-    CalCoefficient c(a, b);
-    CAL_UICPAL_RAINRATE = c;
+    CAL_UICPAL_RAINRATE.a = a;
+    CAL_UICPAL_RAINRATE.b = b;
     saveCalPrefs();
 }
 
 void commandCalibrateRG15RainRate(float a, float b) {
-    CalCoefficient c(a, b);
-    CAL_RG15_RAINRATE = c;
+    CAL_RG15_RAINRATE.a = a;
+    CAL_RG15_RAINRATE.b = b;
     saveCalPrefs();
 }
 
@@ -766,6 +2000,18 @@ void commandHwRg15Off() {
     saveHwPrefs();
 }
 
+void commandHwWindVaneOn() {
+    logConsoleMessage("[CONSOLE] WINDVANE enabled");
+    HARDWARE_WINDVANE = true;
+    saveHwPrefs();
+}
+
+void commandHwWindVaneOff() {
+    logConsoleMessage("[CONSOLE] WINDVANE disabled");
+    HARDWARE_WINDVANE = false;
+    saveHwPrefs();
+}
+
 void commandTempWeightBmp280(float weight) {
     T_WEIGHT_BMP280 = weight;
     saveThWeightsPrefs();
@@ -803,6 +2049,10 @@ void initConsoleCommands() {
     console_commands["helptemp"] = commandHelpTemp;
     console_commands["helphumi"] = commandHelpHumi;
     console_commands["helpcal"] = commandHelpCal;
+    console_commands["helpfilter"] = commandHelpFilter;
+    console_commands["helpsht"] = commandHelpSht;
+    console_commands["helpsky"] = commandHelpSky;
+    console_commands["helpbench"] = commandHelpBench;
 
     console_commands["reboot"] = commandReboot;
 
@@ -810,6 +2060,22 @@ void initConsoleCommands() {
     console_commands["calibrate"] = commandCalibrateState;
     console_commands["calibration"] = commandCalibrateState;
 
+    console_commands["filter"] = commandFilterState;
+    console_commands["filters"] = commandFilterState;
+    console_commands["filterreset"] = commandFilterReset;
+
+    console_commands["drift"] = commandDriftState;
+    console_commands["driftreset"] = commandDriftReset;
+    console_commands["quantiles"] = commandQuantilesState;
+    console_commands["quantilesreset"] = commandQuantilesReset;
+    console_commands["history"] = commandHistoryState;
+    console_commands["historychannels"] = commandHistoryChannels;
+    console_commands["tslog"] = commandTsLogState;
+    console_commands["tslogformat"] = commandTsLogFormat;
+    console_commands["rollup"] = commandRollupState;
+    console_commands["warmstart"] = commandWarmStartState;
+    console_commands["trend"] = commandTrendState;
+
     console_commands["target"] = commandTargetState;
     console_commands["targets"] = commandTargetState;
 
@@ -880,6 +2146,32 @@ void initConsoleCommands() {
     console_commands["hwuicpaloff"] = commandHwUicpalOff;
     console_commands["hwrg15on"] = commandHwRg15On;
     console_commands["hwrg15off"] = commandHwRg15Off;
+    console_commands["hwwindvaneon"] = commandHwWindVaneOn;
+    console_commands["hwwindvaneoff"] = commandHwWindVaneOff;
+
+    console_commands["sht"] = commandShtState;
+    console_commands["sht45"] = commandShtState;
+    console_commands["shtprecisionhigh"] = commandShtPrecisionHigh;
+    console_commands["shtprecisionmedium"] = commandShtPrecisionMedium;
+    console_commands["shtprecisionlow"] = commandShtPrecisionLow;
+    console_commands["shtspreadon"] = commandShtSpreadOn;
+    console_commands["shtspreadoff"] = commandShtSpreadOff;
+    console_commands["shtreport"] = commandShtReport;
+    console_commands["fusion"] = commandFusionState;
+    console_commands["fusionon"] = commandFusionOn;
+    console_commands["fusionoff"] = commandFusionOff;
+    console_commands["sky"] = commandSkyState;
+    console_commands["skyhighrateon"] = commandSkyHighRateOn;
+    console_commands["skyhighrateoff"] = commandSkyHighRateOff;
+
+    console_commands["benchanemo"] = commandBenchAnemo;
+    console_commands["benchsky"] = commandBenchSky;
+    console_commands["benchdew"] = commandBenchDew;
+    console_commands["benchobscon"] = commandBenchObscon;
+    console_commands["benchhistory"] = commandBenchHistory;
+    console_commands["benchtslog"] = commandBenchTsLog;
+    console_commands["benchrollup"] = commandBenchRollup;
+    console_commands["benchtrend"] = commandBenchTrend;
 
     console_commands["uptime"] = commandUptime;
     console_commands["fault"] = commandFaults;
@@ -1110,6 +2402,16 @@ CalibrateCommand parseCalibrateCommand(const std::string &input) {
 }
 
 void processConsoleCommand(const std::string &msg) {
+    // Calibrate table commands
+    std::istringstream words(msg);
+    std::string w1, w2;
+    words >> w1 >> w2;
+    std::transform(w1.begin(), w1.end(), w1.begin(), ::tolower);
+    std::transform(w2.begin(), w2.end(), w2.begin(), ::tolower);
+    if (w1 == "cal" && (w2 == "point" || w2 == "table")) {
+        commandCalibrateTable(msg);
+        return;
+    }
     // Calibrate commands
     CalibrateCommand calc = parseCalibrateCommand(msg);
     if (calc.success) {
@@ -1231,6 +2533,63 @@ void processConsoleCommand(const std::string &msg) {
         commandLogSafemonSlowDelay(static_cast<uint16_t>(std::stoul(cmd.substr(14))));
         return;
     }
+    if (cmd == "skymodeldefault") {
+        commandSkyModelDefault();
+        return;
+    }
+    if (cmd.length() > 8 && cmd.substr(0, 8) == "skymodel") {
+        // Coefficients need the original spacing
+        std::istringstream iss(msg);
+        std::string w1, w2;
+        float k[SKY_MODEL_SIZE - 1];
+        int n = 0;
+        iss >> w1 >> w2;
+        while (n < SKY_MODEL_SIZE - 1 && iss >> k[n]) {
+            n++;
+        }
+        if (n == SKY_MODEL_SIZE - 1) {
+            commandSkyModel(k);
+        } else {
+            logConsoleMessage("[CONSOLE] Sky model needs " + String(SKY_MODEL_SIZE - 1) + " coefficients");
+        }
+        return;
+    }
+    if (cmd.length() > 6 && cmd.substr(0, 6) == "filter" && console_commands.find(cmd) == console_commands.end()) {
+        // Channel names and values need the original spacing
+        commandFilter(msg);
+        return;
+    }
+    if (cmd.length() > 14 && cmd.substr(0, 14) == "tslogretention") {
+        commandTsLogRetention(static_cast<uint16_t>(std::stoul(cmd.substr(14))));
+        return;
+    }
+    if (cmd.length() > 5 && cmd.substr(0, 5) == "tslog" && console_commands.find(cmd) == console_commands.end()) {
+        // Channel name needs the original spacing
+        commandTsLog(msg);
+        return;
+    }
+    if (cmd.length() > 12 && cmd.substr(0, 12) == "warmstartage") {
+        commandWarmStartAge(static_cast<uint16_t>(std::stoul(cmd.substr(12))));
+        return;
+    }
+    if (cmd.length() > 6 && cmd.substr(0, 6) == "rollup" && console_commands.find(cmd) == console_commands.end()) {
+        // Channel name and durations need the original spacing
+        commandRollup(msg);
+        return;
+    }
+    if (cmd.length() > 7 && cmd.substr(0, 7) == "history" && console_commands.find(cmd) == console_commands.end()) {
+        // Channel name and time need the original spacing
+        commandHistory(msg);
+        return;
+    }
+    if (cmd.length() > 9 && cmd.substr(0, 9) == "skywindow") {
+        commandSkyWindow(static_cast<uint16_t>(std::stoul(cmd.substr(9))));
+        return;
+    }
+    if (cmd.length() > 15 && cmd.substr(0, 15) == "shtoversampling") {
+        commandShtOversampling(std::stoul(cmd.substr(15)));
+        return;
+    }
     // Commands
     auto it = console_commands.find(cmd);
     if (it != console_commands.end()) {
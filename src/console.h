@@ -27,6 +27,10 @@ void commandHelpAlpaca();
 void commandHelpTemp();
 void commandHelpHumi();
 void commandHelpCal();
+void commandHelpSht();
+void commandHelpSky();
+void commandHelpFilter();
+void commandHelpBench();
 
 void commandReboot();
 
@@ -51,6 +55,7 @@ void commandCalibrateANEMO4403WindSpeed(float, float);
 void commandCalibrateANEMO4403WindGust(float, float);
 void commandCalibrateUICPALRainRate(float, float);
 void commandCalibrateRG15RainRate(float, float);
+void commandCalibrateTable(const std::string &);
 
 void commandTargetState();
 
@@ -136,6 +141,9 @@ void commandHwUicpalOff();
 void commandHwRg15On();
 void commandHwRg15Off();
 
+void commandHwWindVaneOn();
+void commandHwWindVaneOff();
+
 void commandTempWeightState();
 void commandTempWeightBmp280(float);
 void commandTempWeightAht20(float);
@@ -145,8 +153,61 @@ void commandHumiWeightState();
 void commandHumiWeightAht20(float);
 void commandHumiWeightSht45(float);
 
+void commandFusionState();
+void commandFusionOn();
+void commandFusionOff();
+
+void commandDriftState();
+void commandDriftReset();
+void commandQuantilesState();
+void commandQuantilesReset();
+void commandHistoryState();
+void commandHistoryChannels();
+void commandHistory(const std::string &);
+void commandTsLogState();
+void commandTsLogRetention(uint16_t);
+void commandTsLogFormat();
+void commandTsLog(const std::string &);
+void commandRollupState();
+void commandRollup(const std::string &);
+void commandWarmStartState();
+void commandWarmStartAge(uint16_t);
+void commandTrendState();
+
+void commandFilterState();
+void commandFilterReset();
+void commandFilter(const std::string &);
+
+void commandShtState();
+void commandShtPrecisionHigh();
+void commandShtPrecisionMedium();
+void commandShtPrecisionLow();
+void commandShtOversampling(unsigned long);
+void commandShtSpreadOn();
+void commandShtSpreadOff();
+void commandShtReport();
+void printShtReport(bool);
+
+void commandSkyState();
+void commandSkyWindow(uint16_t);
+void commandSkyHighRateOn();
+void commandSkyHighRateOff();
+void commandSkyModel(const float *);
+void commandSkyModelDefault();
+
+void commandBenchAnemo();
+void commandBenchSky();
+void commandBenchDew();
+void commandBenchObscon();
+void commandBenchHistory();
+void commandBenchTsLog();
+void commandBenchRollup();
+void commandBenchTrend();
+
 void commandUptime();
 void commandFaults();
 
+CalibrateCommand parseCalibrateCommand(const std::string &);
+
 void initConsoleCommands();
 void IRAM_ATTR processConsoleCommand(const std::string &msg);
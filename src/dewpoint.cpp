@@ -0,0 +1,55 @@
+#include "dewpoint.h"
+
+// Lowest humidity taken into account, keeps the logarithm finite
+#define DEW_MIN_RH 0.1
+
+float fastLogf(float x) {
+    union {
+        float f;
+        uint32_t i;
+    } v = {x};
+    // x = m * 2^e, m moved into [sqrt(1/2), sqrt(2)) for a fast converging series
+    int e = (int)((v.i >> 23) & 0xff) - 127;
+    v.i = (v.i & 0x007fffff) | 0x3f800000;
+    float m = v.f;
+    if (m > 1.41421356f) {
+        m *= 0.5f;
+        e++;
+    }
+    // ln(m) = 2 * atanh((m - 1) / (m + 1))
+    float t = (m - 1.0f) / (m + 1.0f);
+    float t2 = t * t;
+    float s = t * (2.0f + t2 * (0.666666667f + t2 * (0.4f + t2 * 0.285714286f)));
+    return s + e * 0.693147181f;
+}
+
+// ln(es(T) / E0) over water
+static inline float gammaWater(float t, float rh) {
+    rh = constrain(rh, DEW_MIN_RH, 100.0f);
+    return fastLogf(rh / 100.0f) + ((float)DEW_BUCK_B - t / (float)DEW_BUCK_D) * (t / ((float)DEW_BUCK_C + t));
+}
+
+float dewPoint(float t, float rh) {
+    float g = gammaWater(t, rh);
+    return (float)DEW_BUCK_C * g / ((float)DEW_BUCK_B - g);
+}
+
+float frostPoint(float t, float rh) {
+    // Same vapor pressure, inverted over ice
+    static const float offset = fastLogf((float)DEW_BUCK_E0 / (float)FROST_MAGNUS_E0);
+    float g = gammaWater(t, rh) + offset;
+    return (float)FROST_MAGNUS_C * g / ((float)FROST_MAGNUS_A - g);
+}
+
+double dewPointRef(double t, double rh) {
+    rh = constrain(rh, DEW_MIN_RH, 100.0);
+    double g = log(rh / 100.0) + (DEW_BUCK_B - t / DEW_BUCK_D) * (t / (DEW_BUCK_C + t));
+    return DEW_BUCK_C * g / (DEW_BUCK_B - g);
+}
+
+double frostPointRef(double t, double rh) {
+    rh = constrain(rh, DEW_MIN_RH, 100.0);
+    double e = rh / 100.0 * DEW_BUCK_E0 * exp((DEW_BUCK_B - t / DEW_BUCK_D) * (t / (DEW_BUCK_C + t)));
+    double g = log(e / FROST_MAGNUS_E0);
+    return FROST_MAGNUS_C * g / (FROST_MAGNUS_A - g);
+}
@@ -0,0 +1,22 @@
+#pragma once
+
+#include <Arduino.h>
+
+// Arden Buck saturation vapor pressure over water: es = 6.1121 * exp((b - T / d) * (T / (c + T))) hPa
+#define DEW_BUCK_B 18.678
+#define DEW_BUCK_C 257.14
+#define DEW_BUCK_D 234.5
+#define DEW_BUCK_E0 6.1121
+// Magnus over ice, inverted for the frost point
+#define FROST_MAGNUS_A 22.452
+#define FROST_MAGNUS_C 272.55
+#define FROST_MAGNUS_E0 6.1115
+
+// Natural logarithm, single precision, absolute error below 1e-6 for normal positive x
+float fastLogf(float x);
+// Dew point and frost point, °C, from temperature °C and relative humidity %
+float dewPoint(float t, float rh);
+float frostPoint(float t, float rh);
+// Double precision reference of the same formulas
+double dewPointRef(double t, double rh);
+double frostPointRef(double t, double rh);
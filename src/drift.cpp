@@ -0,0 +1,103 @@
+#include "drift.h"
+
+void DriftPair::add(float residual) {
+    count++;
+    // Plain mean while warming up, then exponential forgetting
+    float alpha = max((float)DRIFT_ALPHA, 1.0f / count);
+    float d = residual - mean;
+    mean += alpha * d;
+    variance = (1 - alpha) * (variance + alpha * d * d);
+}
+
+void DriftPair::clear() {
+    mean = 0;
+    variance = 0;
+    count = 0;
+}
+
+bool DriftPair::exceeds(float threshold) {
+    return fabsf(mean) > threshold && fabsf(mean) > DRIFT_SIGMA * sqrtf(variance);
+}
+
+// Index of the (i, j) pair, i < j, of n sensors
+static int pairIndex(int i, int j, int n) {
+    return i * (2 * n - i - 1) / 2 + (j - i - 1);
+}
+
+void DriftDetector::update(const float *t, const bool *tAvailable, const float *h, const bool *hAvailable) {
+    for (int i = 0; i < 3; i++) {
+        for (int j = i + 1; j < 3; j++) {
+            if (tAvailable[i] && tAvailable[j]) {
+                temperature[pairIndex(i, j, 3)].add(t[i] - t[j]);
+            }
+        }
+    }
+    if (hAvailable[0] && hAvailable[1]) {
+        humidity.add(h[0] - h[1]);
+    }
+}
+
+void DriftDetector::clear() {
+    for (int i = 0; i < 3; i++) {
+        temperature[i].clear();
+    }
+    humidity.clear();
+}
+
+bool DriftDetector::drifting(DriftPair *pairs, int sensors, int i, float threshold) {
+    int inPairs = 0, inExceed = 0, outPairs = 0, outExceed = 0;
+    for (int a = 0; a < sensors; a++) {
+        for (int b = a + 1; b < sensors; b++) {
+            DriftPair &p = pairs[pairIndex(a, b, sensors)];
+            if (!p.isReady()) {
+                continue;
+            }
+            bool exceed = p.exceeds(threshold);
+            if (a == i || b == i) {
+                inPairs++;
+                inExceed += exceed;
+            } else {
+                outPairs++;
+                outExceed += exceed;
+            }
+        }
+    }
+    if (inPairs == 0 || inExceed < inPairs || outExceed > 0) {
+        return false;
+    }
+    // The only trusted pair can't tell which sensor drifts - both are flagged
+    return inPairs + outPairs == 1 || inPairs >= 2;
+}
+
+float DriftDetector::offset(DriftPair *pairs, int sensors, int i) {
+    float sum = 0;
+    int n = 0;
+    for (int j = 0; j < sensors; j++) {
+        if (j == i) {
+            continue;
+        }
+        DriftPair &p = pairs[pairIndex(min(i, j), max(i, j), sensors)];
+        if (p.isReady()) {
+            // Residual oriented as sensor i - sensor j
+            sum += i < j ? p.mean : -p.mean;
+            n++;
+        }
+    }
+    return n > 0 ? -sum / n : 0;
+}
+
+bool DriftDetector::isTemperatureDrifting(int i) {
+    return drifting(temperature, 3, i, DRIFT_TEMPERATURE_THRESHOLD);
+}
+
+bool DriftDetector::isHumidityDrifting(int i) {
+    return drifting(&humidity, 2, i, DRIFT_HUMIDITY_THRESHOLD);
+}
+
+float DriftDetector::getTemperatureOffset(int i) {
+    return offset(temperature, 3, i);
+}
+
+float DriftDetector::getHumidityOffset(int i) {
+    return offset(&humidity, 2, i);
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <Arduino.h>
+
+// Smoothing factor of the residual trackers per update, ~25 minutes at METEO_MEASURE_DELAY
+#define DRIFT_ALPHA 0.002
+// Updates before a pair is trusted
+#define DRIFT_WARMUP 500
+// Persistent disagreement treated as drift
+#define DRIFT_TEMPERATURE_THRESHOLD 0.5
+#define DRIFT_HUMIDITY_THRESHOLD 3.0
+// Mean residual must also stand out of the residual noise by this many sigmas
+#define DRIFT_SIGMA 2.0
+
+// EWMA mean and variance of the residual of two sensors (a - b)
+struct DriftPair {
+    float mean;
+    float variance;
+    uint32_t count;
+    void add(float residual);
+    void clear();
+    bool isReady() { return count >= DRIFT_WARMUP; }
+    bool exceeds(float threshold);
+};
+
+// Pairwise residuals of sensors measuring the same quantity, constant memory
+// Temperature sensors: 0 - BMP280, 1 - AHT20, 2 - SHT45, humidity: 0 - AHT20, 1 - SHT45
+class DriftDetector {
+  private:
+    // BMP280-AHT20, BMP280-SHT45, AHT20-SHT45
+    DriftPair temperature[3];
+    // AHT20-SHT45
+    DriftPair humidity;
+    bool drifting(DriftPair *pairs, int sensors, int i, float threshold);
+    float offset(DriftPair *pairs, int sensors, int i);
+
+  public:
+    DriftDetector() { clear(); }
+    void update(const float *t, const bool *tAvailable, const float *h, const bool *hAvailable);
+    void clear();
+    DriftPair *getTemperaturePair(int i) { return &temperature[i]; }
+    DriftPair *getHumidityPair() { return &humidity; }
+    // A sensor disagreeing with the others, or both sensors of the only trusted pair
+    bool isTemperatureDrifting(int i);
+    bool isHumidityDrifting(int i);
+    // Suggested calibration offset of a sensor against the other sensors
+    float getTemperatureOffset(int i);
+    float getHumidityOffset(int i);
+};
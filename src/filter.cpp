@@ -0,0 +1,151 @@
+#include "filter.h"
+#include <Arduino.h>
+#include <Preferences.h>
+#include <algorithm>
+
+Preferences filterPrefs;
+
+FilterConfig filterConfig[CAL_DATA_SIZE];
+OutlierFilter outlierFilter[CAL_DATA_SIZE];
+
+void OutlierFilter::clear() {
+    head = 0;
+    count = 0;
+}
+
+void OutlierFilter::resetCounters() {
+    total = 0;
+    rejected = 0;
+}
+
+void OutlierFilter::insert(float value) {
+    float *pos = std::upper_bound(sorted, sorted + count, value);
+    memmove(pos + 1, pos, (sorted + count - pos) * sizeof(float));
+    *pos = value;
+    count++;
+}
+
+void OutlierFilter::remove(float value) {
+    float *pos = std::lower_bound(sorted, sorted + count, value);
+    count--;
+    memmove(pos, pos + 1, (sorted + count - pos) * sizeof(float));
+}
+
+float OutlierFilter::getMedian() {
+    if (count == 0) {
+        return 0;
+    }
+    if (count % 2) {
+        return sorted[count / 2];
+    }
+    return (sorted[count / 2 - 1] + sorted[count / 2]) / 2;
+}
+
+float OutlierFilter::getSigma() {
+    if (count < 2) {
+        return 0;
+    }
+    return (sorted[(3 * count) / 4] - sorted[count / 4]) / FILTER_IQR_SIGMA;
+}
+
+float OutlierFilter::add(float value, const FilterConfig &config) {
+    if (config.mode == FilterMode::Off) {
+        // Stale samples must not judge the first ones after the filter is back on
+        clear();
+        return value;
+    }
+    if (std::isnan(value)) {
+        return value;
+    }
+    uint8_t size = constrain(config.window, 3, FILTER_MAX_WINDOW);
+    if (size != window) {
+        window = size;
+        clear();
+    }
+    total++;
+    // Test against the previous samples only, a full window is needed for a meaningful spread
+    bool outlier = false;
+    float median = getMedian();
+    if (count == window) {
+        float sigma = max(getSigma(), config.floor);
+        outlier = fabsf(value - median) > config.threshold * sigma;
+        if (outlier) {
+            rejected++;
+        }
+        remove(ring[head]);
+    }
+    // Raw value goes into the window anyway, a real step is accepted after half a window
+    ring[head] = value;
+    head = (head + 1) % window;
+    insert(value);
+    if (config.mode == FilterMode::Median) {
+        return getMedian();
+    }
+    return outlier ? median : value;
+}
+
+// Replace out of range values (e.g. added after the settings were saved) with defaults
+void checkFilterPrefs() {
+    for (int i = 0; i < CAL_DATA_SIZE; i++) {
+        FilterConfig &c = filterConfig[i];
+        if (c.mode > FilterMode::Median) {
+            c.mode = FilterMode::Off;
+        }
+        c.window = constrain(c.window, 3, FILTER_MAX_WINDOW);
+        if (std::isnan(c.threshold) || c.threshold <= 0) {
+            c.threshold = 3;
+        }
+        if (std::isnan(c.floor) || c.floor < 0) {
+            c.floor = 0;
+        }
+    }
+}
+
+void initFilterPrefs() {
+    filterPrefs.begin("filterPrefs", false);
+    // Default values for current firmware - Hampel on the I2C thermometers, hygrometers and barometer
+    std::fill(std::begin(filterConfig), std::end(filterConfig), FilterConfig());
+    filterConfig[CalDevice::BMP280Temperature] = FilterConfig(FilterMode::Hampel, 5, 3, 0.1);
+    filterConfig[CalDevice::BMP280Pressure] = FilterConfig(FilterMode::Hampel, 5, 3, 0.1);
+    filterConfig[CalDevice::AHT20Temperature] = FilterConfig(FilterMode::Hampel, 5, 3, 0.1);
+    filterConfig[CalDevice::AHT20Humidity] = FilterConfig(FilterMode::Hampel, 5, 3, 0.5);
+    filterConfig[CalDevice::SHT45Temperature] = FilterConfig(FilterMode::Hampel, 5, 3, 0.1);
+    filterConfig[CalDevice::SHT45Humidity] = FilterConfig(FilterMode::Hampel, 5, 3, 0.5);
+    filterConfig[CalDevice::MLX90614Ambient] = FilterConfig(FilterMode::Hampel, 5, 3, 0.1);
+    filterConfig[CalDevice::MLX90614Object] = FilterConfig(FilterMode::Hampel, 5, 3, 0.5);
+    loadFilterPrefs();
+}
+
+void loadFilterPrefs() {
+    if (filterPrefs.isKey("filters")) {
+        filterPrefs.getBytes("filters", filterConfig, sizeof(filterConfig));
+        checkFilterPrefs();
+    }
+}
+
+void saveFilterPrefs() {
+    checkFilterPrefs();
+    filterPrefs.putBytes("filters", filterConfig, sizeof(filterConfig));
+}
+
+float filterSample(float v, int channel) {
+    return outlierFilter[channel].add(v, filterConfig[channel]);
+}
+
+uint32_t filterRejected() {
+    uint32_t n = 0;
+    for (int i = 0; i < CAL_DATA_SIZE; i++) {
+        n += outlierFilter[i].getRejected();
+    }
+    return n;
+}
+
+String filterModeAsString(uint8_t mode) {
+    switch (mode) {
+    case FilterMode::Hampel:
+        return "hampel";
+    case FilterMode::Median:
+        return "median";
+    }
+    return "off";
+}
@@ -0,0 +1,80 @@
+#pragma once
+
+#include "calibrate.h"
+#include <Arduino.h>
+
+// Longest sliding window of a channel filter
+#define FILTER_MAX_WINDOW 15
+// IQR of a normal distribution in sigmas
+#define FILTER_IQR_SIGMA 1.349
+
+class FilterMode {
+  public:
+    static const uint8_t Off = 0;
+    // Replace samples outside median +/- k * sigma with the median
+    static const uint8_t Hampel = 1;
+    // Median of the last N samples
+    static const uint8_t Median = 2;
+};
+
+// Per-channel settings, indexed by CalDevice like the calibration coefficients
+struct FilterConfig {
+    uint8_t mode;
+    uint8_t window;
+    // Rejection threshold k, in robust sigmas
+    float threshold;
+    // Lowest sigma, keeps a quiet (quantized) sensor from rejecting every change
+    float floor;
+    FilterConfig() {
+        mode = FilterMode::Off;
+        window = 5;
+        threshold = 3;
+        floor = 0;
+    }
+    FilterConfig(uint8_t _mode, uint8_t _window, float _threshold, float _floor) {
+        mode = _mode;
+        window = _window;
+        threshold = _threshold;
+        floor = _floor;
+    }
+};
+
+// Sliding median with robust spread, window kept sorted for O(log n) search per sample
+class OutlierFilter {
+  private:
+    // Raw samples in arrival order
+    float ring[FILTER_MAX_WINDOW];
+    // Same samples sorted ascending
+    float sorted[FILTER_MAX_WINDOW];
+    uint8_t window = 0;
+    uint8_t head = 0;
+    uint8_t count = 0;
+    uint32_t total = 0;
+    uint32_t rejected = 0;
+    void insert(float value);
+    void remove(float value);
+
+  public:
+    // Filter a raw sample with the given settings, window changes restart the filter
+    float add(float value, const FilterConfig &config);
+    void clear();
+    void resetCounters();
+    float getMedian();
+    // Robust sigma from the interquartile range
+    float getSigma();
+    uint32_t getTotal() { return total; }
+    uint32_t getRejected() { return rejected; }
+};
+
+extern FilterConfig filterConfig[CAL_DATA_SIZE];
+extern OutlierFilter outlierFilter[CAL_DATA_SIZE];
+
+void checkFilterPrefs();
+void initFilterPrefs();
+void loadFilterPrefs();
+void saveFilterPrefs();
+// Outlier stage ahead of calibrate(), channel is a CalDevice index
+float filterSample(float, int);
+// Rejected samples over all channels
+uint32_t filterRejected();
+String filterModeAsString(uint8_t);
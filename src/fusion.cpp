@@ -0,0 +1,64 @@
+#include "fusion.h"
+
+// Prior with the floor, a zero static weight stays zero
+static float fusionPrior(float prior) {
+    return prior > 0 ? prior + FUSION_PRIOR_FLOOR : 0;
+}
+
+void SensorFusion::clear() {
+    for (int i = 0; i < FUSION_MAX_SENSORS; i++) {
+        channels[i] = {0, FUSION_MIN_VARIANCE, 0, 0, false};
+    }
+    fused = 0;
+    started = false;
+}
+
+float SensorFusion::update(const float *values, const float *priors, const bool *available, const float *penalty, int n) {
+    n = min(n, FUSION_MAX_SENSORS);
+    // Reference for the bias trackers - previous fused value, or the prior weighted mean at start
+    float reference = fused;
+    if (!started) {
+        float s = 0, w = 0;
+        for (int i = 0; i < n; i++) {
+            if (available[i]) {
+                s += fusionPrior(priors[i]) * values[i];
+                w += fusionPrior(priors[i]);
+            }
+        }
+        if (w == 0) {
+            return fused;
+        }
+        reference = s / w;
+    }
+    float sum = 0, total = 0;
+    for (int i = 0; i < n; i++) {
+        Channel &c = channels[i];
+        c.weight = 0;
+        if (!available[i]) {
+            c.started = false;
+            continue;
+        }
+        // Excluded sensor (e.g. heater on) keeps its statistics until it is back
+        if (penalty[i] > 0) {
+            if (c.started) {
+                float d = values[i] - c.last;
+                c.variance += FUSION_ALPHA * (d * d / 2 - c.variance);
+                c.bias += FUSION_ALPHA * (values[i] - reference - c.bias);
+            }
+            c.last = values[i];
+            c.started = true;
+        }
+        float error = max(c.variance + c.bias * c.bias, (float)FUSION_MIN_VARIANCE);
+        c.weight = penalty[i] * fusionPrior(priors[i]) / error;
+        sum += c.weight * values[i];
+        total += c.weight;
+    }
+    if (total > 0) {
+        for (int i = 0; i < n; i++) {
+            channels[i].weight /= total;
+        }
+        fused = sum / total;
+        started = true;
+    }
+    return fused;
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <Arduino.h>
+
+#define FUSION_MAX_SENSORS 3
+// Smoothing factor of the noise and bias trackers per update
+#define FUSION_ALPHA 0.05
+// Error variance floor, keeps a quiet sensor from taking all the weight
+#define FUSION_MIN_VARIANCE 0.0004
+// Share of the static weight every weighted sensor gets as a prior, a zero static weight excludes the sensor
+#define FUSION_PRIOR_FLOOR 0.25
+// AHT20 temperature bias against the ensemble treated as self-heating, °C
+#define FUSION_SELFHEAT_BIAS 0.3
+// Weight factor of a self-heating sensor
+#define FUSION_SELFHEAT_PENALTY 0.1
+
+// Online inverse-variance fusion of redundant sensors with static weights as priors
+class SensorFusion {
+  private:
+    struct Channel {
+        float last;
+        // Noise variance from successive differences
+        float variance;
+        // Mean deviation from the fused value
+        float bias;
+        float weight;
+        bool started;
+    };
+    Channel channels[FUSION_MAX_SENSORS];
+    float fused = 0;
+    bool started = false;
+
+  public:
+    SensorFusion() { clear(); }
+    void clear();
+    // Fuse n readings. Priors are the static weights (0 - excluded), penalty scales the weight (0 - excluded, statistics frozen)
+    float update(const float *values, const float *priors, const bool *available, const float *penalty, int n);
+    float getFused() { return fused; }
+    float getWeight(int i) { return channels[i].weight; }
+    float getVariance(int i) { return channels[i].variance; }
+    float getBias(int i) { return channels[i].bias; }
+};
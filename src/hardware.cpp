@@ -19,7 +19,7 @@ void calcHwPrefs() {
     OBSCON_FWHM = HARDWARE_MLX90614;
     OBSCON_SKYBRIGHTNESS = HARDWARE_TSL2591;
     OBSCON_SKYQUALITY = HARDWARE_TSL2591;
-    OBSCON_WINDDIR = false;
+    OBSCON_WINDDIR = HARDWARE_WINDVANE;
     OBSCON_WINDSPEED = HARDWARE_ANEMO4403;
     OBSCON_WINDGUST = HARDWARE_ANEMO4403;
 
@@ -44,6 +44,7 @@ void initHwPrefs() {
     HARDWARE_UICPAL = FIRMWARE_UICPAL;
     HARDWARE_ANEMO4403 = FIRMWARE_ANEMO4403;
     HARDWARE_RG15 = FIRMWARE_RG15;
+    HARDWARE_WINDVANE = FIRMWARE_WINDVANE;
     ALPACA_OBSCON = FIRMWARE_ALPACA_OBSCON;
     ALPACA_SAFEMON = FIRMWARE_ALPACA_SAFEMON;
     calcHwPrefs();
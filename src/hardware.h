@@ -13,6 +13,7 @@
 #define HARDWARE_ANEMO4403 hwEnabled[hwAnemo4403]
 #define HARDWARE_RG15 hwEnabled[hwRg15]
 #define HARDWARE_DS3231 hwEnabled[hwDs3231]
+#define HARDWARE_WINDVANE hwEnabled[hwWindVane]
 
 #define INITED_DS3231 hwInited[hwDs3231]
 #define INITED_BMP280 hwInited[hwBmp280]
@@ -23,6 +24,7 @@
 #define INITED_UICPAL hwInited[hwUicpal]
 #define INITED_ANEMO4403 hwInited[hwAnemo4403]
 #define INITED_RG15 hwInited[hwRg15]
+#define INITED_WINDVANE hwInited[hwWindVane]
 
 #define ALPACA_OBSCON hwEnabled[alpacaObscon]
 #define ALPACA_SAFEMON hwEnabled[alpacaSafemon]
@@ -64,6 +66,7 @@ enum Hardware {
     hwRg15 = 6,
     hwDs3231 = 7,
     hwSht45 = 8,
+    hwWindVane = 9,
 
     alpacaObscon = 10,
     alpacaSafemon = 11,
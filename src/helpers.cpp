@@ -112,4 +112,33 @@ void faults(int *count, String *description) {
         *count += 1;
         *description += "RG15";
     }
+    if (HARDWARE_WINDVANE && !INITED_WINDVANE) {
+        if (*count > 0) {
+            *description += " ";
+        }
+        *count += 1;
+        *description += "WINDVANE";
+    }
+    // Cross-sensor drift, temperature: BMP280, AHT20, SHT45, humidity: AHT20, SHT45
+    DriftDetector *drift = meteo.getDrift();
+    const char *tNames[] = {"BMP280", "AHT20", "SHT45"};
+    for (int i = 0; i < 3; i++) {
+        if (drift->isTemperatureDrifting(i)) {
+            if (*count > 0) {
+                *description += " ";
+            }
+            *count += 1;
+            *description += String(tNames[i]) + ":T-DRIFT";
+        }
+    }
+    const char *hNames[] = {"AHT20", "SHT45"};
+    for (int i = 0; i < 2; i++) {
+        if (drift->isHumidityDrifting(i)) {
+            if (*count > 0) {
+                *description += " ";
+            }
+            *count += 1;
+            *description += String(hNames[i]) + ":H-DRIFT";
+        }
+    }
 }
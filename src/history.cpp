@@ -0,0 +1,271 @@
+#include "history.h"
+#include <time.h>
+
+HistoryStore history;
+
+// Quantization of the channels, decimals kept
+static const struct {
+    const char *name;
+    uint8_t decimals;
+} historyChannels[HISTORY_CHANNELS] = {
+    {"uicpal_rate", 2},
+    {"rg15_rate", 2},
+    {"rain_rate", 2},
+    {"bmp_temperature", 2},
+    {"bmp_pressure", 2},
+    {"aht_temperature", 2},
+    {"aht_humidity", 1},
+    {"sht_temperature", 2},
+    {"sht_humidity", 1},
+    {"temperature", 2},
+    {"humidity", 1},
+    {"dew_point", 2},
+    {"frost_point", 2},
+    {"mlx_tempamb", 2},
+    {"mlx_tempobj", 2},
+    {"sky_temperature", 2},
+    {"cloud_cover", 0},
+    {"cloud_class", 0},
+    {"noise_db", 1},
+    {"snr_db", 1},
+    {"turbulence", 1},
+    {"sky_quality", 2},
+    {"sky_brightness", 3},
+    {"wind_direction", 0},
+    {"wind_speed", 1},
+    {"wind_gust", 1},
+    {"wind_speed_3s", 1},
+    {"wind_speed_2m", 1},
+    {"wind_speed_10m", 1},
+    {"wind_gust_10m", 1},
+    {"pressure_tendency_1h", 2},
+    {"pressure_tendency_3h", 2},
+    {"temperature_trend", 2},
+    {"humidity_trend", 1},
+    {"sky_temperature_trend", 2}};
+
+// Out of range and NaN values, decoded as NaN
+static const int64_t HISTORY_INVALID = INT64_MIN / 2;
+
+static const float historyScale[] = {1, 10, 100, 1000};
+
+static int64_t quantize(float value, int channel) {
+    float scaled = value * historyScale[historyChannels[channel].decimals];
+    if (std::isnan(scaled) || fabsf(scaled) > 2e9) {
+        return HISTORY_INVALID;
+    }
+    return (int64_t)lroundf(scaled);
+}
+
+static float dequantize(int64_t value, int channel) {
+    if (value == HISTORY_INVALID) {
+        return NAN;
+    }
+    return value / historyScale[historyChannels[channel].decimals];
+}
+
+static uint8_t *putVarint(uint8_t *p, uint64_t v) {
+    while (v >= 0x80) {
+        *p++ = (uint8_t)v | 0x80;
+        v >>= 7;
+    }
+    *p++ = (uint8_t)v;
+    return p;
+}
+
+static const uint8_t *getVarint(const uint8_t *p, uint64_t *v) {
+    uint64_t result = 0;
+    int shift = 0;
+    while (*p & 0x80) {
+        result |= (uint64_t)(*p++ & 0x7f) << shift;
+        shift += 7;
+    }
+    *v = result | ((uint64_t)*p++ << shift);
+    return p;
+}
+
+// Small deltas of either sign to small unsigned numbers
+static uint64_t zigzag(int64_t v) {
+    return ((uint64_t)v << 1) ^ (uint64_t)(v >> 63);
+}
+
+static int64_t unzigzag(uint64_t v) {
+    return (int64_t)(v >> 1) ^ -(int64_t)(v & 1);
+}
+
+bool HistoryStore::begin(uint8_t *storage, uint32_t blockCount) {
+    if (!mutex) {
+        mutex = xSemaphoreCreateMutex();
+    }
+    buffer = storage;
+    blocks = storage ? blockCount : 0;
+    clear();
+    return isReady();
+}
+
+void HistoryStore::startBlock(uint32_t block) {
+    *header(block) = {0, 0, 0, 0};
+    for (int i = 0; i < HISTORY_CHANNELS; i++) {
+        previous[i] = 0;
+    }
+}
+
+void HistoryStore::clear() {
+    if (!buffer) {
+        return;
+    }
+    xSemaphoreTake(mutex, portMAX_DELAY);
+    head = 0;
+    filled = 0;
+    records = 0;
+    previousTime = 0;
+    startBlock(head);
+    xSemaphoreGive(mutex);
+}
+
+uint32_t HistoryStore::encode(uint8_t *record, uint32_t delta, const int64_t *values) {
+    uint8_t *p = putVarint(record, delta);
+    for (int i = 0; i < HISTORY_CHANNELS; i++) {
+        p = putVarint(p, zigzag(values[i] - previous[i]));
+    }
+    return p - record;
+}
+
+void HistoryStore::add(uint32_t time, const float *values) {
+    if (!buffer) {
+        return;
+    }
+    int64_t q[HISTORY_CHANNELS];
+    for (int i = 0; i < HISTORY_CHANNELS; i++) {
+        q[i] = quantize(values[i], i);
+    }
+    uint8_t record[HISTORY_MAX_RECORD];
+    xSemaphoreTake(mutex, portMAX_DELAY);
+    HistoryBlockHeader *h = header(head);
+    uint32_t size = 0;
+    if (h->records > 0 && time >= previousTime) {
+        size = encode(record, time - previousTime, q);
+    }
+    // Record does not fit or the clock went back (NTP sync) - next block, the oldest one is dropped
+    if (h->records > 0 && (time < previousTime || h->used + size > HISTORY_BLOCK_SIZE - sizeof(HistoryBlockHeader))) {
+        head = (head + 1) % blocks;
+        if (filled < blocks - 1) {
+            filled++;
+        } else {
+            records -= header(head)->records;
+        }
+        startBlock(head);
+        h = header(head);
+    }
+    // First record of a block is absolute
+    if (h->records == 0) {
+        h->first = time;
+        size = encode(record, 0, q);
+    }
+    memcpy(payload(head) + h->used, record, size);
+    for (int i = 0; i < HISTORY_CHANNELS; i++) {
+        previous[i] = q[i];
+    }
+    h->used += size;
+    h->last = time;
+    h->records++;
+    previousTime = time;
+    records++;
+    xSemaphoreGive(mutex);
+}
+
+uint32_t HistoryStore::query(int channel, uint32_t from, uint32_t to, std::function<void(uint32_t, float)> callback) {
+    if (!buffer || channel < 0 || channel >= HISTORY_CHANNELS) {
+        return 0;
+    }
+    uint32_t decoded = 0;
+    xSemaphoreTake(mutex, portMAX_DELAY);
+    for (uint32_t n = 0; n <= filled; n++) {
+        uint32_t block = (head + blocks - filled + n) % blocks;
+        HistoryBlockHeader *h = header(block);
+        if (h->records == 0 || h->last < from || h->first > to) {
+            continue;
+        }
+        const uint8_t *p = payload(block);
+        uint32_t time = h->first;
+        int64_t value = 0;
+        for (uint16_t r = 0; r < h->records; r++) {
+            uint64_t v;
+            p = getVarint(p, &v);
+            time += v;
+            // Channels before and after the requested one are skipped, not decoded
+            for (int i = 0; i < HISTORY_CHANNELS; i++) {
+                if (i == channel) {
+                    p = getVarint(p, &v);
+                    value += unzigzag(v);
+                } else {
+                    while (*p++ & 0x80) {
+                    }
+                }
+            }
+            decoded++;
+            if (time > to) {
+                break;
+            }
+            if (time >= from) {
+                callback(time, dequantize(value, channel));
+            }
+        }
+    }
+    xSemaphoreGive(mutex);
+    return decoded;
+}
+
+uint32_t HistoryStore::getUsed() {
+    if (!buffer) {
+        return 0;
+    }
+    xSemaphoreTake(mutex, portMAX_DELAY);
+    uint32_t used = 0;
+    for (uint32_t n = 0; n <= filled; n++) {
+        used += sizeof(HistoryBlockHeader) + header((head + blocks - filled + n) % blocks)->used;
+    }
+    xSemaphoreGive(mutex);
+    return used;
+}
+
+uint32_t HistoryStore::getOldest() {
+    if (!buffer) {
+        return 0;
+    }
+    xSemaphoreTake(mutex, portMAX_DELAY);
+    uint32_t oldest = header((head + blocks - filled) % blocks)->first;
+    xSemaphoreGive(mutex);
+    return oldest;
+}
+
+void initHistory() {
+    uint8_t *storage = nullptr;
+    if (psramFound()) {
+        storage = (uint8_t *)ps_malloc(HISTORY_BLOCKS * HISTORY_BLOCK_SIZE);
+    }
+    history.begin(storage, HISTORY_BLOCKS);
+}
+
+uint32_t historyTime() {
+    return time(nullptr);
+}
+
+const char *historyChannelName(int channel) {
+    return historyChannels[channel].name;
+}
+
+int historyChannelFromString(String name) {
+    name.trim();
+    name.toLowerCase();
+    for (int i = 0; i < HISTORY_CHANNELS; i++) {
+        if (name == historyChannels[i].name) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+uint8_t historyChannelDecimals(int channel) {
+    return historyChannels[channel].decimals;
+}
@@ -0,0 +1,116 @@
+#pragma once
+
+#include <Arduino.h>
+#include <functional>
+
+// Block of the ring store, self-contained so the oldest one can be dropped at any time
+#define HISTORY_BLOCK_SIZE 2048
+// ~1.5 MB of PSRAM, 24 hours of every channel at METEO_MEASURE_DELAY with ~50 bytes per record
+#define HISTORY_BLOCKS 768
+// Worst case record, time and every channel as 10 byte varints
+#define HISTORY_MAX_RECORD (10 * (HISTORY_CHANNELS + 1))
+// Console output limit of a query
+#define HISTORY_CONSOLE_LINES 40
+
+// Stored channels, in Meteo::sensors order
+class HistoryChannel {
+  public:
+    static const int UicpalRate = 0;
+    static const int Rg15Rate = 1;
+    static const int RainRate = 2;
+    static const int Bmp280Temperature = 3;
+    static const int Bmp280Pressure = 4;
+    static const int Aht20Temperature = 5;
+    static const int Aht20Humidity = 6;
+    static const int Sht45Temperature = 7;
+    static const int Sht45Humidity = 8;
+    static const int Temperature = 9;
+    static const int Humidity = 10;
+    static const int DewPoint = 11;
+    static const int FrostPoint = 12;
+    static const int Mlx90614Ambient = 13;
+    static const int Mlx90614Object = 14;
+    static const int SkyTemperature = 15;
+    static const int CloudCover = 16;
+    static const int CloudClass = 17;
+    static const int NoiseDb = 18;
+    static const int SnrDb = 19;
+    static const int Turbulence = 20;
+    static const int SkyQuality = 21;
+    static const int SkyBrightness = 22;
+    static const int WindDirection = 23;
+    static const int WindSpeed = 24;
+    static const int WindGust = 25;
+    static const int WindSpeed3s = 26;
+    static const int WindSpeed2m = 27;
+    static const int WindSpeed10m = 28;
+    static const int WindGust10m = 29;
+    static const int PressureTendency1h = 30;
+    static const int PressureTendency3h = 31;
+    static const int TemperatureTrend = 32;
+    static const int HumidityTrend = 33;
+    static const int SkyTemperatureTrend = 34;
+};
+#define HISTORY_CHANNELS 35
+
+// Block header, times are epoch seconds (uptime based until NTP sync)
+struct HistoryBlockHeader {
+    uint32_t first;
+    uint32_t last;
+    uint16_t records;
+    uint16_t used;
+};
+
+// Compressed ring store of every channel at native resolution
+// Values are quantized to the channel decimals, each record holds the time and value deltas
+// to the previous record of the block as zigzag varints, the first record of a block is absolute
+class HistoryStore {
+  private:
+    uint8_t *buffer = nullptr;
+    uint32_t blocks = 0;
+    // Block being written and completed blocks before it
+    uint32_t head = 0;
+    uint32_t filled = 0;
+    // Encoder state of the head block
+    int64_t previous[HISTORY_CHANNELS];
+    uint32_t previousTime = 0;
+    uint32_t records = 0;
+    SemaphoreHandle_t mutex = nullptr;
+    HistoryBlockHeader *header(uint32_t block) { return (HistoryBlockHeader *)(buffer + block * HISTORY_BLOCK_SIZE); }
+    uint8_t *payload(uint32_t block) { return buffer + block * HISTORY_BLOCK_SIZE + sizeof(HistoryBlockHeader); }
+    void startBlock(uint32_t block);
+    // Record against the encoder state, returns its size
+    uint32_t encode(uint8_t *record, uint32_t delta, const int64_t *values);
+
+  public:
+    ~HistoryStore() {
+        if (mutex) {
+            vSemaphoreDelete(mutex);
+        }
+    }
+    // Use a caller provided buffer of blocks * HISTORY_BLOCK_SIZE bytes
+    bool begin(uint8_t *storage, uint32_t blockCount);
+    bool isReady() { return buffer != nullptr; }
+    void clear();
+    void add(uint32_t time, const float *values);
+    // Values of a channel in [from, to], oldest first, returns the number of records decoded
+    uint32_t query(int channel, uint32_t from, uint32_t to, std::function<void(uint32_t, float)> callback);
+    // Records held
+    uint32_t getRecords() { return records; }
+    // Bytes held, headers included
+    uint32_t getUsed();
+    uint32_t getCapacity() { return blocks * HISTORY_BLOCK_SIZE; }
+    uint32_t getOldest();
+    uint32_t getNewest() { return previousTime; }
+};
+
+extern HistoryStore history;
+
+// Allocate the store in PSRAM, disabled without it
+void initHistory();
+// Seconds for history records, epoch once the clock is set
+uint32_t historyTime();
+const char *historyChannelName(int channel);
+// Channel by name, -1 if unknown
+int historyChannelFromString(String name);
+uint8_t historyChannelDecimals(int channel);
@@ -1,10 +1,16 @@
 #include "main.h"
 #include "calibrate.h"
 #include "console.h"
+#include "filter.h"
 #include "hardware.h"
+#include "history.h"
 #include "log.h"
+#include "rollup.h"
 #include "secrets.h"
+#include "settings.h"
+#include "tslog.h"
 #include "version.h"
+#include "warmstart.h"
 #include "weights.h"
 #include <jled.h>
 
@@ -156,6 +162,7 @@ void workload(void *parameter) {
     static unsigned long safetyMonitorLastRan = 0;
     static unsigned long observingConditionsLastRan = 0;
     static unsigned long uptimeNextRun = 0;
+    static bool checkpoint = false;
     // mqtt status loop delay
     static int prevWifiStatus = WL_DISCONNECTED;
     static int mqttStatusDelay = MQTT_STATUS_DELAY;
@@ -197,6 +204,7 @@ void workload(void *parameter) {
             if (immediate || readiness || (millis() > observingConditionsLastRan + (1000 * observingconditions.getRefresh()))) {
                 observingconditions.update(&meteo);
                 observingConditionsLastRan = millis();
+                checkpoint = true;
             }
         }
         // update safetymonitor every METEO_MEASURE_DELAY without blocking webserver
@@ -204,8 +212,14 @@ void workload(void *parameter) {
             if (immediate || readiness || (millis() > safetyMonitorLastRan + SAFETY_MONITOR_DELAY)) {
                 safetymonitor.update(&meteo);
                 safetyMonitorLastRan = millis();
+                checkpoint = true;
             }
         }
+        // averages and safety state for a warm start after a reset
+        if (checkpoint) {
+            saveWarmStart(&observingconditions, &safetymonitor);
+            checkpoint = false;
+        }
         if (millis() > uptimeNextRun) {
             logMessage("[MAIN][UPTIME] " + uptime());
             int count;
@@ -258,6 +272,26 @@ void setup() {
     initThWeightsPrefs();
     // Calibration preferences
     initCalPrefs();
+    // Sensor settings preferences
+    initSensorSettingsPrefs();
+    // Outlier filter preferences
+    initFilterPrefs();
+    // Warm start preferences
+    initWarmStart();
+    // Sensor history in PSRAM
+    initHistory();
+    if (!history.isReady()) {
+        logMessage("[HISTORY] PSRAM not available, history disabled", false);
+    }
+    // Minute log on the tslog flash partition
+    initTsLog();
+    if (!tslog.isReady()) {
+        logMessage("[TSLOG] Partition \"" TSLOG_PARTITION "\" not found, flash log disabled", false);
+        // OTA never rewrites the partition table
+        logMessage("[TSLOG] Flash partitions.csv over serial to add it, an OTA update can not", false);
+    }
+    // 1 min to 1 day rollups, rebuilt from the flash log
+    initRollups();
     // System Timezone
     setenv("TZ", RTC_TIMEZONE, 1);
     tzset();
@@ -347,6 +381,13 @@ void setup() {
         alpacaServer.addDevice(&safetymonitor);
     }
     alpacaServer.loadSettings();
+    // Warm start, averages and safety countdowns resume after a reset or an OTA
+    int32_t warmAge = restoreWarmStart(&observingconditions, &safetymonitor);
+    if (warmAge >= 0) {
+        logMessage("[WARMSTART] Restored " + String(warmAge) + "s old averages and safety state", false);
+    } else {
+        logMessage("[WARMSTART] No checkpoint younger than " + String(getWarmStartMaxAge()) + "s, cold start", false);
+    }
     // Meteo sensors
     meteo.getTsl2591()->setDataReadyCallback(tslDataReadyHandler);
     meteo.setLogger(LogSource::Meteo, logLine, logLinePart, logTime);
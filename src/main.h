@@ -23,5 +23,7 @@ extern PicoMQTT::Client *mqttClient;
 extern JLed led;
 extern WIFIMANAGER WifiManager;
 extern OTAWEBUPDATER OtaWebUpdater;
+extern Meteo meteo;
+extern ObservingConditions observingconditions;
 
 void setup_wifi();
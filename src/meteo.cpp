@@ -1,7 +1,12 @@
 #include "meteo.h"
 #include "calibrate.h"
+#include "dewpoint.h"
+#include "filter.h"
 #include "hardware.h"
 #include "helpers.h"
+#include "history.h"
+#include "settings.h"
+#include "tslog.h"
 #include "weights.h"
 
 Adafruit_BMP280 bmp;
@@ -9,8 +14,9 @@ Adafruit_AHTX0 aht;
 SHT45AutoHeat sht;
 Adafruit_MLX90614 mlx;
 TSL2591AutoGain tsl;
-PCNTFrequencyCounter anm((gpio_num_t)WIND_SENSOR_PIN);
+PCNTFrequencyCounter anm((gpio_num_t)WIND_SENSOR_PIN, PCNT_UNIT_0, 100, PCNTEdge::Falling, 100, true);
 RGAsync rg15;
+ADCWindVane vane;
 
 void Meteo::logMessage(String msg, bool showtime) {
     if (logLine && logLinePart) {
@@ -56,14 +62,130 @@ void Meteo::setLogger(const int logSrc, std::function<void(String, const int)> l
     tsl.setLogger(LogSource::Tech, logLine, logLinePart, logTime);
     sht.setLogger(LogSource::Tech, logLine, logLinePart, logTime);
     rg15.setLogger(LogSource::Tech, logLine, logLinePart, logTime);
+    vane.setLogger(LogSource::Tech, logLine, logLinePart, logTime);
 }
 
 TSL2591AutoGain *Meteo::getTsl2591() {
     return &tsl;
 }
 
+SHT45AutoHeat *Meteo::getSht45() {
+    return &sht;
+}
+
+bool Meteo::requestSht45Report(std::function<void(bool)> done) {
+    if (sht45ReportPending) {
+        return false;
+    }
+    sht45ReportDone = done;
+    sht45ReportPending = true;
+    xEventGroupSetBits(xDevicesGroup, SHT45_REPORT);
+    return true;
+}
+
+PCNTFrequencyCounter *Meteo::getAnemo4403() {
+    return &anm;
+}
+
+ADCWindVane *Meteo::getWindVane() {
+    return &vane;
+}
+
+SensorFusion *Meteo::getTemperatureFusion() {
+    return &temperatureFusion;
+}
+
+SensorFusion *Meteo::getHumidityFusion() {
+    return &humidityFusion;
+}
+
+DriftDetector *Meteo::getDrift() {
+    return &drift;
+}
+
+SlidingRegression *Meteo::getTrend(int channel) {
+    return &trends[channel];
+}
+
+void Meteo::updateTrends() {
+    bool thOk = (HARDWARE_AHT20 && INITED_AHT20) || (HARDWARE_SHT45 && INITED_SHT45);
+    if (HARDWARE_BMP280 && INITED_BMP280) {
+        trends[TrendChannel::Pressure].add(sensors.bmp_pressure);
+    }
+    if (thOk || (HARDWARE_BMP280 && INITED_BMP280)) {
+        trends[TrendChannel::Temperature].add(sensors.temperature);
+    }
+    if (thOk) {
+        trends[TrendChannel::Humidity].add(sensors.humidity);
+    }
+    if (HARDWARE_MLX90614 && INITED_MLX90614) {
+        trends[TrendChannel::SkyTemperature].add(sensors.sky_temperature);
+    }
+    // Tendency is the fitted change over the window, trends are per hour
+    SlidingRegression &pressure = trends[TrendChannel::Pressure];
+    sensors.pressure_tendency_1h = pressure.getSlope(TrendWindow::Hour) * pressure.getWindow(TrendWindow::Hour);
+    sensors.pressure_tendency_3h = pressure.getSlope(TrendWindow::ThreeHours) * pressure.getWindow(TrendWindow::ThreeHours);
+    sensors.temperature_trend = trends[TrendChannel::Temperature].getSlope(TrendWindow::Hour) * 3600;
+    sensors.humidity_trend = trends[TrendChannel::Humidity].getSlope(TrendWindow::Hour) * 3600;
+    sensors.sky_temperature_trend = trends[TrendChannel::SkyTemperature].getSlope(TrendWindow::Hour) * 3600;
+}
+
+String Meteo::trend(float v, int p) {
+    return std::isnan(v) ? String("n/a") : trimmed(v, p);
+}
+
+void Meteo::updateHistory() {
+    const float values[HISTORY_CHANNELS] = {
+        sensors.uicpal_rate, sensors.rg15_rate, sensors.rain_rate,
+        sensors.bmp_temperature, sensors.bmp_pressure,
+        sensors.aht_temperature, sensors.aht_humidity,
+        sensors.sht_temperature, sensors.sht_humidity,
+        sensors.temperature, sensors.humidity, sensors.dew_point, sensors.frost_point,
+        sensors.mlx_tempamb, sensors.mlx_tempobj, sensors.sky_temperature, sensors.cloud_cover, sensors.cloud_class,
+        sensors.noise_db, sensors.snr_db,
+        sensors.turbulence,
+        sensors.sky_quality, sensors.sky_brightness,
+        sensors.wind_direction, sensors.wind_speed, sensors.wind_gust,
+        sensors.wind_speed_3s, sensors.wind_speed_2m, sensors.wind_speed_10m, sensors.wind_gust_10m,
+        sensors.pressure_tendency_1h, sensors.pressure_tendency_3h, sensors.temperature_trend, sensors.humidity_trend, sensors.sky_temperature_trend};
+    uint32_t time = historyTime();
+    history.add(time, values);
+    tslogSample(time, values);
+}
+
+void Meteo::updateDrift() {
+    bool ahtOk = HARDWARE_AHT20 && INITED_AHT20;
+    // SHT45 heater cycles are not drift
+    bool shtOk = HARDWARE_SHT45 && INITED_SHT45 && !sht.isHeating();
+    const float t[] = {sensors.bmp_temperature, sensors.aht_temperature, sensors.sht_temperature};
+    const bool tAvailable[] = {HARDWARE_BMP280 && INITED_BMP280, ahtOk, shtOk};
+    const float h[] = {sensors.aht_humidity, sensors.sht_humidity};
+    const bool hAvailable[] = {ahtOk, shtOk};
+    drift.update(t, tAvailable, h, hAvailable);
+}
+
+void Meteo::updateFusion() {
+    bool bmpOk = HARDWARE_BMP280 && INITED_BMP280;
+    bool ahtOk = HARDWARE_AHT20 && INITED_AHT20;
+    bool shtOk = HARDWARE_SHT45 && INITED_SHT45;
+    // SHT45 heater and AHT20 self-heating bias the readings
+    float shtPenalty = shtOk && sht.isHeating() ? 0 : 1;
+    float ahtPenalty = temperatureFusion.getBias(1) > FUSION_SELFHEAT_BIAS ? FUSION_SELFHEAT_PENALTY : 1;
+    const float tValues[] = {sensors.bmp_temperature, sensors.aht_temperature, sensors.sht_temperature};
+    const float tPriors[] = {T_NORM_WEIGHT_BMP280, T_NORM_WEIGHT_AHT20, T_NORM_WEIGHT_SHT45};
+    const bool tAvailable[] = {bmpOk, ahtOk, shtOk};
+    const float tPenalty[] = {1, ahtPenalty, shtPenalty};
+    sensors.temperature = calibrate(temperatureFusion.update(tValues, tPriors, tAvailable, tPenalty, 3), CAL_TEMPERATURE);
+    const float hValues[] = {sensors.aht_humidity, sensors.sht_humidity};
+    const float hPriors[] = {H_NORM_WEIGHT_AHT20, H_NORM_WEIGHT_SHT45};
+    const bool hAvailable[] = {ahtOk, shtOk};
+    const float hPenalty[] = {ahtPenalty, shtPenalty};
+    sensors.humidity = calibrate(humidityFusion.update(hValues, hPriors, hAvailable, hPenalty, 2), CAL_HUMIDITY);
+}
+
 void Meteo::begin() {
     xDevicesGroup = xEventGroupCreate();
+    setSkyModel();
     Wire.end();
     Wire.setPins(I2C_SDA_PIN, I2C_SCL_PIN);
     Wire.begin();
@@ -126,6 +248,7 @@ void Meteo::begin() {
     if (HARDWARE_SHT45) {
         if (sht.begin()) {
             INITED_SHT45 = true;
+            sht.setPrecision(SHT45_PRECISION, SHT45_OVERSAMPLING, SHT45_SPREAD);
             xTaskCreate(
                 Meteo::updateSht45Wrapper,
                 "updateSht45",
@@ -138,6 +261,8 @@ void Meteo::begin() {
     if (HARDWARE_MLX90614) {
         if (mlx.begin(I2C_MLX_ADDR)) {
             INITED_MLX90614 = true;
+            skyNoise.setWindow(SKY_NOISE_WINDOW);
+            setSkyHighRate(SKY_HIGH_RATE);
             xTaskCreate(
                 Meteo::updateMlx90614Wrapper,
                 "updateMlx80614",
@@ -163,19 +288,24 @@ void Meteo::begin() {
         if (anm.begin()) {
             INITED_ANEMO4403 = true;
             xTaskCreate(
-                Meteo::updateAnemo4403SpeedWrapper,
-                "updateAnemo4403Speed",
+                Meteo::updateAnemo4403Wrapper,
+                "updateAnemo4403",
                 4096,
                 this,
                 1,
-                &updateAnemo4403SpeedHandle);
+                &updateAnemo4403Handle);
+        }
+    }
+    if (HARDWARE_WINDVANE) {
+        if (vane.begin()) {
+            INITED_WINDVANE = true;
             xTaskCreate(
-                Meteo::updateAnemo4403GustWrapper,
-                "updateAnemo4403Gust",
+                Meteo::updateWindVaneWrapper,
+                "updateWindVane",
                 4096,
                 this,
                 1,
-                &updateAnemo4403GustHandle);
+                &updateWindVaneHandle);
         }
     }
 }
@@ -217,7 +347,7 @@ void Meteo::updateRg15() {
                 rg15.forceUpdate();
             }
             RGData d = rg15.getData();
-            sensors.rg15_rate = calibrate(d.rainfallIntensity, CAL_RG15_RAINRATE);
+            sensors.rg15_rate = calibrate(filterSample(d.rainfallIntensity, CalDevice::RG15RainRate), CAL_RG15_RAINRATE);
             last_update = millis();
             force_update = false;
             xEventGroupSetBits(xDevicesGroup, RG15_DONE);
@@ -240,8 +370,8 @@ void Meteo::updateBmp280() {
     static bool force_update = true;
     while (true) {
         if (force_update || millis() - last_update > METEO_MEASURE_DELAY) {
-            sensors.bmp_temperature = calibrate(bmp.readTemperature(), CAL_BMP280_TEMPERATURE);
-            sensors.bmp_pressure = calibrate(bmp.readPressure() / 100.0F, CAL_BMP280_PRESSURE);
+            sensors.bmp_temperature = calibrate(filterSample(bmp.readTemperature(), CalDevice::BMP280Temperature), CAL_BMP280_TEMPERATURE);
+            sensors.bmp_pressure = calibrate(filterSample(bmp.readPressure() / 100.0F, CalDevice::BMP280Pressure), CAL_BMP280_PRESSURE);
             last_update = millis();
             force_update = false;
             xEventGroupSetBits(xDevicesGroup, BMP280_DONE);
@@ -266,8 +396,8 @@ void Meteo::updateAht20() {
         if (force_update || millis() - last_update > METEO_MEASURE_DELAY) {
             sensors_event_t aht_sensor_humidity, aht_sensor_temp;
             aht.getEvent(&aht_sensor_humidity, &aht_sensor_temp);
-            sensors.aht_temperature = calibrate(aht_sensor_temp.temperature, CAL_AHT20_TEMPERATURE);
-            sensors.aht_humidity = calibrate(aht_sensor_humidity.relative_humidity, CAL_AHT20_HUMIDITY);
+            sensors.aht_temperature = calibrate(filterSample(aht_sensor_temp.temperature, CalDevice::AHT20Temperature), CAL_AHT20_TEMPERATURE);
+            sensors.aht_humidity = calibrate(filterSample(aht_sensor_humidity.relative_humidity, CalDevice::AHT20Humidity), CAL_AHT20_HUMIDITY);
             last_update = millis();
             force_update = false;
             xEventGroupSetBits(xDevicesGroup, AHT20_DONE);
@@ -287,13 +417,19 @@ void Meteo::updateAht20() {
 void Meteo::updateSht45() {
     EventBits_t xBits;
     static unsigned long last_update = 0;
+    static unsigned long last_sample = 0;
     static bool force_update = true;
     while (true) {
+        // Spread oversampling measures across the sampling window
+        if (sht.isSpread() && millis() - last_sample >= METEO_MEASURE_DELAY / sht.getOversampling()) {
+            sht.sample();
+            last_sample = millis();
+        }
         if (force_update || millis() - last_update > METEO_MEASURE_DELAY) {
             SHT45Data measure = sht.readData();
             if (measure.valid) {
-                sensors.sht_temperature = calibrate(measure.temperature, CAL_SHT45_TEMPERATURE);
-                sensors.sht_humidity = calibrate(measure.humidity, CAL_SHT45_HUMIDITY);
+                sensors.sht_temperature = calibrate(filterSample(measure.temperature, CalDevice::SHT45Temperature), CAL_SHT45_TEMPERATURE);
+                sensors.sht_humidity = calibrate(filterSample(measure.humidity, CalDevice::SHT45Humidity), CAL_SHT45_HUMIDITY);
             }
             last_update = millis();
             force_update = false;
@@ -301,43 +437,55 @@ void Meteo::updateSht45() {
         }
         xBits = xEventGroupWaitBits(
             xDevicesGroup,
-            SHT45_KICK,
+            SHT45_KICK | SHT45_REPORT,
             pdTRUE,
             pdFALSE,
             pdMS_TO_TICKS(METEO_TASK_SLEEP));
         if ((xBits & SHT45_KICK) != 0) {
             force_update = true;
         }
+        // Report measures take seconds, they hold this task and not the caller
+        if ((xBits & SHT45_REPORT) != 0) {
+            bool done = sht.runReport();
+            if (sht45ReportDone) {
+                sht45ReportDone(done);
+            }
+            sht45ReportPending = false;
+        }
     }
 }
 
 void Meteo::updateMlx90614() {
     EventBits_t xBits;
     static unsigned long last_update = 0;
+    static unsigned long last_sample = 0;
     static bool force_update = true;
     while (true) {
+        // High rate object temperature for the turbulence spectrum
+        if (skyHighRate && millis() - last_sample >= TURBULENCE_SAMPLE_MS) {
+            double val = mlx.readObjectTempC();
+            if (!std::isnan(val)) {
+                // Same filter settings and calibration chain as the sky temperature below
+                float obj = calibrate(skyHighRateFilter.add(val, filterConfig[CalDevice::MLX90614Object]), CAL_MLX90614_OBJECT);
+                turbulence.add(calibrate(tsky_calc(obj, sensors.mlx_tempamb), CAL_MLX90614_SKYTEMP));
+            }
+            last_sample = millis();
+        }
         if (force_update || millis() - last_update > METEO_MEASURE_DELAY) {
             double val;
             val = mlx.readAmbientTempC();
             if (!std::isnan(val)) {
-                sensors.mlx_tempamb = calibrate(val, CAL_MLX90614_AMBIENT);
+                sensors.mlx_tempamb = calibrate(filterSample(val, CalDevice::MLX90614Ambient), CAL_MLX90614_AMBIENT);
             }
             val = mlx.readObjectTempC();
             if (!std::isnan(val)) {
-                sensors.mlx_tempobj = calibrate(val, CAL_MLX90614_OBJECT);
+                sensors.mlx_tempobj = calibrate(filterSample(val, CalDevice::MLX90614Object), CAL_MLX90614_OBJECT);
             }
             sensors.sky_temperature = calibrate(tsky_calc(sensors.mlx_tempobj, sensors.mlx_tempamb), CAL_MLX90614_SKYTEMP);
-            // add tempsky value to circular buffer and calculate
             // Turbulence (noise dB) / Seeing estimation
-            cb_add(sensors.sky_temperature);
-            sensors.noise_db = cb_noise_db_calc();
-            sensors.cloud_cover = calibrate(100. + (sensors.sky_temperature * 6.), CAL_MLX90614_CLOUDCOVER);
-            if (sensors.cloud_cover > 100.) {
-                sensors.cloud_cover = 100.;
-            }
-            if (sensors.cloud_cover < 0.) {
-                sensors.cloud_cover = 0.;
-            }
+            updateSkyNoise(sensors.sky_temperature);
+            updateTurbulence();
+            updateCloudCover();
             last_update = millis();
             force_update = false;
             xEventGroupSetBits(xDevicesGroup, MLX90614_DONE);
@@ -347,7 +495,7 @@ void Meteo::updateMlx90614() {
             MLX90614_KICK,
             pdTRUE,
             pdFALSE,
-            pdMS_TO_TICKS(METEO_TASK_SLEEP));
+            pdMS_TO_TICKS(skyHighRate ? TURBULENCE_SAMPLE_MS / 2 : METEO_TASK_SLEEP));
         if ((xBits & MLX90614_KICK) != 0) {
             force_update = true;
         }
@@ -364,7 +512,7 @@ void Meteo::updateTsl2591() {
                 tsl.forceUpdate();
             }
             TSL2591Data tslData = tsl.getData();
-            sensors.sky_brightness = calibrate(tsl.calculateLux(tslData), CAL_TSL2591_SKYBRIGHTNESS);
+            sensors.sky_brightness = calibrate(filterSample(tsl.calculateLux(tslData), CalDevice::TSL2591SkyBrightness), CAL_TSL2591_SKYBRIGHTNESS);
             sensors.sky_quality = calibrate(tsl.calculateSQM(tslData), CAL_TSL2591_SKYQUALITY);
             last_update = millis();
             force_update = false;
@@ -382,17 +530,31 @@ void Meteo::updateTsl2591() {
     }
 }
 
-void Meteo::updateAnemo4403Speed() {
+float Meteo::anemoSpeed(float frequency) {
+    // 1.05 Hz per km/h, then m/s
+    return (frequency / 1.05) / 3.6;
+}
+
+void Meteo::updateAnemo4403() {
     EventBits_t xBits;
     static unsigned long last_update = 0;
+    static unsigned long last_tick = 0;
     static bool force_update = true;
     while (true) {
+        // Wind statistics tick, 3 s rolling mean at 4 Hz
+        if (force_update || millis() - last_tick >= WIND_TICK_MS) {
+            windStats.add(anm.getBlendedFrequency(WIND_GUST_WINDOW_MS), anm.getCurrentCount(), millis());
+            sensors.wind_speed_3s = calibrate(anemoSpeed(windStats.getMean3s()), CAL_ANEMO4403_WINDSPEED);
+            sensors.wind_speed_2m = calibrate(anemoSpeed(windStats.getMean2m()), CAL_ANEMO4403_WINDSPEED);
+            sensors.wind_speed_10m = calibrate(anemoSpeed(windStats.getMean10m()), CAL_ANEMO4403_WINDSPEED);
+            sensors.wind_gust = calibrate(anemoSpeed(windStats.getGust2m()), CAL_ANEMO4403_WINDGUST);
+            sensors.wind_gust_10m = calibrate(anemoSpeed(windStats.getGust10m()), CAL_ANEMO4403_WINDGUST);
+            last_tick = millis();
+        }
+        // Wind speed over the custom measure cycle
         if (force_update || millis() - last_update > METEO_MEASURE_DELAY) {
-            // Different cycles for wind_speed (custom)
-            // and wind_gust (always 3 sec then 2 minutes max)
-            // 40 values max - every 3 sec on 2 minutes
-            float f = anm.getFrequency(METEO_MEASURE_DELAY);
-            sensors.wind_speed = calibrate((f / 1.05) / 3.6, CAL_ANEMO4403_WINDSPEED);
+            float f = anm.getBlendedFrequency(METEO_MEASURE_DELAY);
+            sensors.wind_speed = calibrate(anemoSpeed(f), CAL_ANEMO4403_WINDSPEED);
             last_update = millis();
             force_update = false;
             xEventGroupSetBits(xDevicesGroup, ANEMO4403_DONE);
@@ -402,24 +564,35 @@ void Meteo::updateAnemo4403Speed() {
             ANEMO4403_KICK,
             pdTRUE,
             pdFALSE,
-            pdMS_TO_TICKS(METEO_TASK_SLEEP));
+            pdMS_TO_TICKS(WIND_TICK_MS));
         if ((xBits & ANEMO4403_KICK) != 0) {
             force_update = true;
         }
     }
 }
 
-void Meteo::updateAnemo4403Gust() {
-    // May not be forced at all
+void Meteo::updateWindVane() {
+    EventBits_t xBits;
+    static bool force_update = true;
     while (true) {
-        // Different cycles for wind_speed (custom)
-        // and wind_gust (always 3 sec then 2 minutes max)
-        // 40 values max - every 3 sec on 2 minutes
-        float f = anm.getFrequency(3000);
-        float s = (f / 1.05) / 3.6;
-        wind_gust_ra.add(s);
-        sensors.wind_gust = calibrate(wind_gust_ra.getMaxInBuffer(), CAL_ANEMO4403_WINDGUST);
-        vTaskDelay(pdMS_TO_TICKS(3000));
+        // Direction weighted by the 3 s wind speed, equal weights without anemometer
+        float speed = HARDWARE_ANEMO4403 && INITED_ANEMO4403 ? sensors.wind_speed_3s : 1;
+        if (vane.update(speed) || force_update) {
+            sensors.wind_direction = vane.getDirection();
+            if (force_update) {
+                force_update = false;
+                xEventGroupSetBits(xDevicesGroup, WINDVANE_DONE);
+            }
+        }
+        xBits = xEventGroupWaitBits(
+            xDevicesGroup,
+            WINDVANE_KICK,
+            pdTRUE,
+            pdFALSE,
+            pdMS_TO_TICKS(WIND_TICK_MS));
+        if ((xBits & WINDVANE_KICK) != 0) {
+            force_update = true;
+        }
     }
 }
 
@@ -476,6 +649,11 @@ void Meteo::update(bool force) {
             xKick |= ANEMO4403_KICK;
             xWait |= ANEMO4403_DONE;
         }
+        if (HARDWARE_WINDVANE && INITED_WINDVANE) {
+            xDone |= WINDVANE_DONE;
+            xKick |= WINDVANE_KICK;
+            xWait |= WINDVANE_DONE;
+        }
         xEventGroupClearBits(xDevicesGroup, xDone);
         xEventGroupSetBits(xDevicesGroup, xKick);
         xEventGroupWaitBits(xDevicesGroup, xWait, pdFALSE, pdTRUE, pdMS_TO_TICKS(METEO_FORCE_DELAY));
@@ -524,15 +702,24 @@ void Meteo::update(bool force) {
         message += " TS:n/a HS:n/a";
     }
 
-    sensors.temperature = calibrate(T_NORM_WEIGHT_BMP280 * sensors.bmp_temperature + T_NORM_WEIGHT_AHT20 * sensors.aht_temperature + T_NORM_WEIGHT_SHT45 * sensors.sht_temperature, CAL_TEMPERATURE);
-    sensors.humidity = calibrate(H_NORM_WEIGHT_AHT20 * sensors.aht_humidity + H_NORM_WEIGHT_SHT45 * sensors.sht_humidity, CAL_HUMIDITY);
+    updateDrift();
+
+    if (FUSION_ENABLED) {
+        updateFusion();
+    } else {
+        sensors.temperature = calibrate(T_NORM_WEIGHT_BMP280 * sensors.bmp_temperature + T_NORM_WEIGHT_AHT20 * sensors.aht_temperature + T_NORM_WEIGHT_SHT45 * sensors.sht_temperature, CAL_TEMPERATURE);
+        sensors.humidity = calibrate(H_NORM_WEIGHT_AHT20 * sensors.aht_humidity + H_NORM_WEIGHT_SHT45 * sensors.sht_humidity, CAL_HUMIDITY);
+    }
 
     if ((HARDWARE_AHT20 && INITED_AHT20) || (HARDWARE_SHT45 && INITED_SHT45)) {
-        sensors.dew_point = calibrate(sensors.temperature - (100 - sensors.humidity) / 5., CAL_DEW_POINT);
+        sensors.dew_point = calibrate(dewPoint(sensors.temperature, sensors.humidity), CAL_DEW_POINT);
+        sensors.frost_point = calibrate(frostPoint(sensors.temperature, sensors.humidity), CAL_DEW_POINT);
         message += " DP:" + trimmed(sensors.dew_point, 1);
+        message += " FP:" + trimmed(sensors.frost_point, 1);
     } else {
         sensors.dew_point = 0;
-        message += " DP:n/a";
+        sensors.frost_point = 0;
+        message += " DP:n/a FP:n/a";
     }
 
     if (HARDWARE_MLX90614 && INITED_MLX90614) {
@@ -540,14 +727,20 @@ void Meteo::update(bool force) {
         message += " MO:" + trimmed(sensors.mlx_tempobj, 1);
         message += " ST:" + trimmed(sensors.sky_temperature, 1);
         message += " TR:" + trimmed(sensors.noise_db, 1);
+        message += " SN:" + trimmed(sensors.snr_db, 1);
+        message += " TI:" + trimmed(sensors.turbulence, 1);
         message += " CC:" + trimmed(sensors.cloud_cover, 0);
+        message += " CS:" + CloudClassifier::classAsString(sensors.cloud_class);
     } else {
         sensors.mlx_tempamb = 0;
         sensors.mlx_tempobj = 0;
         sensors.sky_temperature = 0;
         sensors.noise_db = 0;
+        sensors.snr_db = 0;
+        sensors.turbulence = 0;
         sensors.cloud_cover = 0;
-        message += " MA:n/a MO:n/a ST:n/a TR:n/a CC:n/a";
+        sensors.cloud_class = CloudClass::Clear;
+        message += " MA:n/a MO:n/a ST:n/a TR:n/a SN:n/a TI:n/a CC:n/a CS:n/a";
     }
 
     if (HARDWARE_TSL2591 && INITED_TSL2591) {
@@ -560,10 +753,30 @@ void Meteo::update(bool force) {
     if (HARDWARE_ANEMO4403 && INITED_ANEMO4403) {
         message += " WS:" + trimmed(sensors.wind_speed, 1);
         message += " WG:" + trimmed(sensors.wind_gust, 1);
+        message += " W2:" + trimmed(sensors.wind_speed_2m, 1);
+        message += " W10:" + trimmed(sensors.wind_speed_10m, 1);
+        message += " G10:" + trimmed(sensors.wind_gust_10m, 1);
+    } else {
+        message += " WS:n/a WG:n/a W2:n/a W10:n/a G10:n/a";
+    }
+
+    if (HARDWARE_WINDVANE && INITED_WINDVANE) {
+        message += " WD:" + trimmed(sensors.wind_direction, 0);
     } else {
-        message += " WS:n/a WG:n/a";
+        sensors.wind_direction = 0;
+        message += " WD:n/a";
     }
-    message += " WD:n/a";
+
+    updateTrends();
+    message += " PT1:" + trend(sensors.pressure_tendency_1h, 2);
+    message += " PT3:" + trend(sensors.pressure_tendency_3h, 2);
+    message += " TT:" + trend(sensors.temperature_trend, 2);
+    message += " HT:" + trend(sensors.humidity_trend, 1);
+    message += " STT:" + trend(sensors.sky_temperature_trend, 2);
+
+    message += " RJ:" + String(filterRejected());
+
+    updateHistory();
 
     if (logEnabled[LogSource::Meteo] == Log::On || (logEnabled[LogSource::Meteo] == Log::Slow && millis() - last_message > logSlow[LogSource::Meteo] * 1000)) {
         logMessage(message);
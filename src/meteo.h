@@ -1,25 +1,25 @@
 #pragma once
 
+#include "cloudcover.h"
 #include "config.h"
+#include "drift.h"
+#include "filter.h"
+#include "fusion.h"
 #include "meteoanm.h"
 #include "meteosht.h"
 #include "meteotsl.h"
+#include "meteovane.h"
 #include "meteorg15.h"
+#include "statistics.h"
+#include "trend.h"
+#include "turbulence.h"
+#include "windstats.h"
 #include <Adafruit_AHTX0.h>
 #include <Adafruit_BMP280.h>
 #include <Adafruit_MLX90614.h>
 #include <Arduino.h>
-#include <RunningAverage.h>
 #include <Wire.h>
 
-// Circular buffer functions
-#define CB_SIZE 40
-static float cb[CB_SIZE] = {0.};
-static float cb_noise[CB_SIZE] = {0.};
-static int cb_index = 0;
-static float cb_avg = 0.0;
-static float cb_rms = 0.0;
-
 // Devices group bits
 #define UICPAL_KICK (1UL << 0)
 #define UICPAL_DONE (1UL << 1)
@@ -37,6 +37,9 @@ static float cb_rms = 0.0;
 #define ANEMO4403_DONE (1UL << 13)
 #define RG15_KICK (1UL << 14)
 #define RG15_DONE (1UL << 15)
+#define SHT45_REPORT (1UL << 16)
+#define WINDVANE_KICK (1UL << 17)
+#define WINDVANE_DONE (1UL << 18)
 
 #ifndef METEO_H
 #define METEO_H
@@ -52,11 +55,16 @@ class Meteo {
         float bmp_temperature, bmp_pressure;
         float aht_temperature, aht_humidity;
         float sht_temperature, sht_humidity;
-        float temperature, humidity, dew_point;
-        float mlx_tempamb, mlx_tempobj, sky_temperature, cloud_cover;
-        float noise_db;
+        float temperature, humidity, dew_point, frost_point;
+        float mlx_tempamb, mlx_tempobj, sky_temperature, cloud_cover, cloud_class;
+        float noise_db, snr_db;
+        // Served as FWHM proxy, FFT band index in high rate mode, noise dB otherwise
+        float turbulence;
         float sky_quality, sky_brightness;
         float wind_direction, wind_speed, wind_gust;
+        float wind_speed_3s, wind_speed_2m, wind_speed_10m, wind_gust_10m;
+        // Least squares slopes, per hour, NaN until the window is covered
+        float pressure_tendency_1h, pressure_tendency_3h, temperature_trend, humidity_trend, sky_temperature_trend;
     } sensors = {0};
     // methods
     void update(bool force = false);
@@ -68,12 +76,39 @@ class Meteo {
     void setLogger(const int source, std::function<void(String, const int)> logLineCallback = nullptr, std::function<void(String, const int)> logLinePartCallback = nullptr, std::function<String()> logTimeCallback = nullptr);
 
     TSL2591AutoGain *getTsl2591();
+    SHT45AutoHeat *getSht45();
+    // SHT45 precision report in the SHT45 task, done gets the runReport result there, false if one is pending
+    bool requestSht45Report(std::function<void(bool)> done);
+    PCNTFrequencyCounter *getAnemo4403();
+    ADCWindVane *getWindVane();
+    // Temperature (BMP280, AHT20, SHT45) and humidity (AHT20, SHT45) fusion
+    SensorFusion *getTemperatureFusion();
+    SensorFusion *getHumidityFusion();
+    // Cross-sensor temperature and humidity drift
+    DriftDetector *getDrift();
+    // Sliding regression of a TrendChannel
+    SlidingRegression *getTrend(int channel);
+    // Sky temperature model, recalculate invariant terms after skyModel changes
+    void setSkyModel();
+    // Sky temperature, single precision with precomputed terms
+    float tsky_calc(float ts, float ta);
+    // Sky temperature, reference double precision evaluation
+    double tsky_calc_ref(double ts, double ta);
+    // Sky temperature noise window in samples
+    void setSkyNoiseWindow(int size);
+    int getSkyNoiseWindow();
+    // Sky temperature high rate sampling for the FFT turbulence index
+    void setSkyHighRate(bool enable);
+    bool getSkyHighRate();
 
   private:
     // Formatting
     String trimmed(float, int);
-    // Wind gust calculation
-    RunningAverage wind_gust_ra = RunningAverage(40);
+    // n/a until the trend window is covered
+    String trend(float, int);
+    // Wind statistics
+    WindStatistics windStats;
+    float anemoSpeed(float frequency);
     // Last log message
     unsigned long last_message = 0;
     // Logger println
@@ -93,13 +128,33 @@ class Meteo {
     // Print a part of log tech message, can be overwritten
     virtual void logTechMessagePart(String msg, bool showtime = false);
 
-    // CB functions
-    float tsky_calc(float ts, float ta);
-    float cb_avg_calc();
-    float cb_rms_calc();
-    void cb_add(float value);
-    float cb_noise_db_calc();
-    float cb_snr_calc();
+    // Sky temperature model invariant terms
+    struct {
+        float c0, c1, c3, c45, k6, s6, c7;
+    } skyTerms;
+    // Turbulence (noise dB) / Seeing estimation
+    RollingStatistics skyNoise;
+    void updateSkyNoise(float value);
+    // Temperature and humidity
+    SensorFusion temperatureFusion;
+    SensorFusion humidityFusion;
+    void updateFusion();
+    DriftDetector drift;
+    void updateDrift();
+    // Pressure tendency and temperature, humidity and sky temperature trends
+    SlidingRegression trends[TREND_CHANNELS];
+    void updateTrends();
+    // Record of every channel into the history store and the flash log
+    void updateHistory();
+    // Cloud cover classification
+    CloudClassifier clouds;
+    void updateCloudCover();
+    // High rate sky temperature spectrum
+    TurbulenceEstimator turbulence;
+    // Object temperature outlier stage of the high rate samples, apart from the 3 s window
+    OutlierFilter skyHighRateFilter;
+    volatile bool skyHighRate = false;
+    void updateTurbulence();
 
     TSL2591Settings autoGainSettings[TSL_SETTINGS_SIZE];
 
@@ -154,6 +209,8 @@ class Meteo {
         instance->updateSht45();
     }
     void updateSht45(void);
+    std::function<void(bool)> sht45ReportDone = nullptr;
+    volatile bool sht45ReportPending = false;
 
     // MLX90614 Task
     TaskHandle_t updateMlx90614Handle = NULL;
@@ -175,25 +232,25 @@ class Meteo {
     }
     void updateTsl2591(void);
 
-    // ANEMO4403 Wind Speed Task
-    TaskHandle_t updateAnemo4403SpeedHandle = NULL;
-    static void updateAnemo4403SpeedWrapper(void *parameter) {
+    // ANEMO4403 Wind Task
+    TaskHandle_t updateAnemo4403Handle = NULL;
+    static void updateAnemo4403Wrapper(void *parameter) {
         // Cast parameter back to the class instance pointer
         Meteo *instance = static_cast<Meteo *>(parameter);
         // Call the actual member function
-        instance->updateAnemo4403Speed();
+        instance->updateAnemo4403();
     }
-    void updateAnemo4403Speed(void);
+    void updateAnemo4403(void);
 
-    // ANEMO4403 Wind Gust Task
-    TaskHandle_t updateAnemo4403GustHandle = NULL;
-    static void updateAnemo4403GustWrapper(void *parameter) {
+    // Wind Vane Task
+    TaskHandle_t updateWindVaneHandle = NULL;
+    static void updateWindVaneWrapper(void *parameter) {
         // Cast parameter back to the class instance pointer
         Meteo *instance = static_cast<Meteo *>(parameter);
         // Call the actual member function
-        instance->updateAnemo4403Gust();
+        instance->updateWindVane();
     }
-    void updateAnemo4403Gust(void);
+    void updateWindVane(void);
 };
 
 #endif
\ No newline at end of file
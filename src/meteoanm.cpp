@@ -15,45 +15,66 @@ void IRAM_ATTR PCNTFrequencyCounter::pcntISR(void *arg) {
 }
 
 void IRAM_ATTR PCNTFrequencyCounter::tmrISR() {
-    // Находим нужный экземпляр через статический массив
+    // Одна метка времени для всех экземпляров
+    uint64_t timestamp = esp_timer_get_time(); // Микросекунды с загрузки
+    // Опрашиваем все активные экземпляры
     for (int i = 0; i < PCNT_UNIT_MAX; i++) {
         PCNTFrequencyCounter *self = instances[i];
-        if (self && self->tmr) {
-            BaseType_t xHigherPriorityTaskWoken = pdFALSE;
+        if (self && self->active) {
+            // Запрошенный сброс до снимка, новый буфер начинается с нуля
+            if (self->resetRequested.load(std::memory_order_acquire)) {
+                self->applyReset();
+            }
             // Быстрое чтение счетчика
             int16_t count;
             pcnt_get_counter_value(self->pcntUnit, &count);
             // Формируем снимок с точной меткой времени
             PCNTCounterSnapshot snapshot;
-            snapshot.timestamp = esp_timer_get_time(); // Микросекунды с загрузки
+            snapshot.timestamp = timestamp;
             snapshot.count = (uint64_t)self->overflowCount * 32768ULL + (uint64_t)count;
-            // Отправляем в очередь (неблокирующая операция)
-            xQueueSendFromISR(self->dataQueue, &snapshot, &xHigherPriorityTaskWoken);
-            if (xHigherPriorityTaskWoken) {
-                portYIELD_FROM_ISR();
-            }
-            break;
+            // Запись прямо в буфер своего экземпляра, без очереди и фоновой задачи
+            self->pushSnapshot(snapshot);
         }
     }
 }
 
-// Фоновая задача обработки данных
-void PCNTFrequencyCounter::processingTaskFunction(void *parameter) {
-    PCNTFrequencyCounter *self = static_cast<PCNTFrequencyCounter *>(parameter);
-    PCNTCounterSnapshot snapshot;
-    while (true) {
-        // Ожидаем данные из очереди
-        if (xQueueReceive(self->dataQueue, &snapshot, portMAX_DELAY) == pdTRUE) {
-            // Обработка данных в фоне
-            portENTER_CRITICAL(&self->spinlock);
-            self->buffer[self->bufferIndex] = snapshot;
-            self->bufferIndex = (self->bufferIndex + 1) % BUFFER_SIZE;
-            if (self->bufferFilled < BUFFER_SIZE) {
-                self->bufferFilled++;
-            }
-            portEXIT_CRITICAL(&self->spinlock);
-        }
+// Метка времени фронта для измерения периода
+void IRAM_ATTR PCNTFrequencyCounter::edgeISR(void *arg) {
+    PCNTFrequencyCounter *self = static_cast<PCNTFrequencyCounter *>(arg);
+    uint64_t timestamp = esp_timer_get_time();
+    portENTER_CRITICAL_ISR(&self->spinlock);
+    uint32_t n = self->edgesWritten;
+    // Дребезг контакта - пропускаем слишком близкие фронты
+    if (n == 0 || timestamp - self->edges[(n - 1) % PCNT_EDGE_BUFFER] >= PCNT_EDGE_DEBOUNCE_US) {
+        self->edges[n % PCNT_EDGE_BUFFER] = timestamp;
+        self->edgesWritten = n + 1;
     }
+    portEXIT_CRITICAL_ISR(&self->spinlock);
+}
+
+// Запись снимка, единственный писатель - прерывание таймера
+void IRAM_ATTR PCNTFrequencyCounter::pushSnapshot(const PCNTCounterSnapshot &snapshot) {
+    uint32_t seq = sequence.load(std::memory_order_relaxed);
+    sequence.store(seq + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    uint32_t n = written.load(std::memory_order_relaxed);
+    buffer[n % BUFFER_SIZE] = snapshot;
+    written.store(n + 1, std::memory_order_relaxed);
+    sequence.store(seq + 2, std::memory_order_release);
+}
+
+// Сброс в контексте писателя - прерывание таймера или неактивный экземпляр
+void IRAM_ATTR PCNTFrequencyCounter::applyReset() {
+    uint32_t seq = sequence.load(std::memory_order_relaxed);
+    sequence.store(seq + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    pcnt_counter_pause(pcntUnit);
+    pcnt_counter_clear(pcntUnit);
+    overflowCount = 0;
+    written.store(0, std::memory_order_relaxed);
+    pcnt_counter_resume(pcntUnit);
+    sequence.store(seq + 2, std::memory_order_release);
+    resetRequested.store(false, std::memory_order_release);
 }
 
 void PCNTFrequencyCounter::initPCNT() {
@@ -62,8 +83,8 @@ void PCNTFrequencyCounter::initPCNT() {
         .ctrl_gpio_num = PCNT_PIN_NOT_USED,
         .lctrl_mode = PCNT_MODE_KEEP,
         .hctrl_mode = PCNT_MODE_KEEP,
-        .pos_mode = PCNT_COUNT_DIS,
-        .neg_mode = PCNT_COUNT_INC,
+        .pos_mode = (edgeMode & PCNTEdge::Rising) ? PCNT_COUNT_INC : PCNT_COUNT_DIS,
+        .neg_mode = (edgeMode & PCNTEdge::Falling) ? PCNT_COUNT_INC : PCNT_COUNT_DIS,
         .counter_h_lim = 32767,
         .counter_l_lim = -32768,
         .unit = pcntUnit,
@@ -71,14 +92,20 @@ void PCNTFrequencyCounter::initPCNT() {
     };
     pcnt_unit_config(&pcnt_config);
     // Фильтр для подавления помех
-    pcnt_set_filter_value(pcntUnit, 100);
-    pcnt_filter_enable(pcntUnit);
+    if (filterValue > 0) {
+        pcnt_set_filter_value(pcntUnit, filterValue > 1023 ? 1023 : filterValue);
+        pcnt_filter_enable(pcntUnit);
+    } else {
+        pcnt_filter_disable(pcntUnit);
+    }
     // События переполнения
     pcnt_event_enable(pcntUnit, PCNT_EVT_H_LIM);
     pcnt_event_enable(pcntUnit, PCNT_EVT_L_LIM);
-    // Регистрация ISR
+    // Регистрация ISR, сервис общий для всех экземпляров
     instances[pcntUnit] = this;
-    pcnt_isr_service_install(0);
+    if (activeCount == 0) {
+        pcnt_isr_service_install(0);
+    }
     pcnt_isr_handler_add(pcntUnit, pcntISR, this);
     // Запуск счетчика
     pcnt_counter_pause(pcntUnit);
@@ -87,112 +114,118 @@ void PCNTFrequencyCounter::initPCNT() {
 }
 
 void PCNTFrequencyCounter::initTMR() {
-    tmr = timerBegin(pcntUnit, 80, true);
-    timerAttachInterrupt(tmr, &tmrISR, true);
-    timerAlarmWrite(tmr, samplePeriodMs * 1000, true);
-    timerAlarmEnable(tmr);
+    // Таймер запускает первый экземпляр, остальные используют его период
+    if (tmr == NULL) {
+        tmrPeriodMs = samplePeriodMs;
+        tmr = timerBegin(PCNT_TIMER_NUM, 80, true);
+        timerAttachInterrupt(tmr, &tmrISR, true);
+        timerAlarmWrite(tmr, tmrPeriodMs * 1000, true);
+        timerAlarmEnable(tmr);
+    }
+    samplePeriodMs = tmrPeriodMs;
 }
 
-bool PCNTFrequencyCounter::begin(UBaseType_t taskPriority) {
-    // Создаем очередь
-    dataQueue = xQueueCreate(16, sizeof(PCNTCounterSnapshot));
-    if (dataQueue == NULL) {
-        return false;
-    }
-    // Создаем фоновую задачу
-    BaseType_t result = xTaskCreate(
-        processingTaskFunction,
-        "PCNTFreqCounter",
-        4096,
-        this,
-        taskPriority,
-        &processingTask);
-    if (result != pdPASS) {
-        vQueueDelete(dataQueue);
-        dataQueue = NULL;
-        return false;
+bool PCNTFrequencyCounter::begin() {
+    if (active) {
+        return true;
     }
     // Инициализация GPIO
     pinMode(inputPin, INPUT_PULLUP);
     // Инициализация PCNT и таймера
     initPCNT();
     initTMR();
+    // Метки фронтов через прерывание GPIO на том же выводе
+    if (periodCapture) {
+        int mode = edgeMode == PCNTEdge::Both ? CHANGE : (edgeMode == PCNTEdge::Rising ? RISING : FALLING);
+        attachInterruptArg(inputPin, edgeISR, this, mode);
+    }
+    active = true;
+    activeCount++;
     return true;
 }
 
 void PCNTFrequencyCounter::end() {
-    if (tmr) {
-        timerAlarmDisable(tmr);
-        timerDetachInterrupt(tmr);
-        timerEnd(tmr);
-        tmr = NULL;
+    if (!active) {
+        return;
     }
-    if (processingTask) {
-        vTaskDelete(processingTask);
-        processingTask = NULL;
-    }
-    if (dataQueue) {
-        vQueueDelete(dataQueue);
-        dataQueue = NULL;
+    active = false;
+    activeCount--;
+    if (periodCapture) {
+        detachInterrupt(inputPin);
     }
     pcnt_isr_handler_remove(pcntUnit);
-    pcnt_isr_service_uninstall();
     instances[pcntUnit] = NULL;
+    // Последний экземпляр останавливает общий таймер и сервис прерываний
+    if (activeCount == 0) {
+        if (tmr) {
+            timerAlarmDisable(tmr);
+            timerDetachInterrupt(tmr);
+            timerEnd(tmr);
+            tmr = NULL;
+        }
+        pcnt_isr_service_uninstall();
+    }
 }
 
 // Получение количества импульсов в скользящем окне
 uint64_t PCNTFrequencyCounter::getCount(uint32_t windowSizeMs) {
-    portENTER_CRITICAL(&spinlock);
-    if (bufferFilled < 2) {
-        portEXIT_CRITICAL(&spinlock);
-        return 0; // Недостаточно данных для расчета
-    }
-    uint64_t currentTime = esp_timer_get_time(); // Микросекунды
-    uint64_t windowStart = currentTime - (windowSizeMs * 1000ULL);
-    // Последнее значение
-    int lastIdx = (bufferIndex - 1 + BUFFER_SIZE) % BUFFER_SIZE;
-    uint64_t lastCount = buffer[lastIdx].count;
-    uint64_t lastTime = buffer[lastIdx].timestamp;
-    // Самое старое доступное значение
-    int oldestIdx = (lastIdx - bufferFilled + 1 + BUFFER_SIZE) % BUFFER_SIZE;
-    uint64_t oldestTime = buffer[oldestIdx].timestamp;
-    // Если запрошенное окно больше доступных данных - используем всё что есть
-    if (windowStart < oldestTime) {
-        windowStart = oldestTime;
-    }
-    // Поиск начала окна
-    uint64_t startCount = lastCount;
-    bool found = false;
-    for (int i = 0; i < bufferFilled; i++) {
-        int idx = (lastIdx - i + BUFFER_SIZE) % BUFFER_SIZE;
-        if (buffer[idx].timestamp <= windowStart) {
-            if (i > 0) {
+    while (true) {
+        // Писатель обновляет буфер - повторяем чтение
+        uint32_t seq = sequence.load(std::memory_order_acquire);
+        if (seq & 1) {
+            continue;
+        }
+        uint32_t n = written.load(std::memory_order_relaxed);
+        uint32_t filled = n < BUFFER_SIZE ? n : BUFFER_SIZE;
+        if (filled < 2) {
+            return 0; // Недостаточно данных для расчета
+        }
+        uint32_t first = n - filled;
+        uint64_t currentTime = esp_timer_get_time(); // Микросекунды
+        uint64_t windowStart = currentTime > windowSizeMs * 1000ULL ? currentTime - (windowSizeMs * 1000ULL) : 0;
+        // Последнее значение
+        const PCNTCounterSnapshot &last = snapshotAt(first, filled - 1);
+        // Самое старое доступное значение
+        const PCNTCounterSnapshot &oldest = snapshotAt(first, 0);
+        uint64_t startCount;
+        if (windowStart <= oldest.timestamp) {
+            // Если запрошенное окно больше доступных данных - используем всё что есть
+            startCount = oldest.count;
+        } else {
+            // Бинарный поиск последнего снимка не позже начала окна
+            uint32_t lo = 0, hi = filled - 1;
+            while (lo < hi) {
+                uint32_t mid = (lo + hi + 1) / 2;
+                if (snapshotAt(first, mid).timestamp <= windowStart) {
+                    lo = mid;
+                } else {
+                    hi = mid - 1;
+                }
+            }
+            const PCNTCounterSnapshot &s1 = snapshotAt(first, lo);
+            if (lo == filled - 1) {
+                startCount = s1.count;
+            } else {
                 // Интерполяция между двумя точками
-                int prevIdx = (idx + 1) % BUFFER_SIZE;
-                uint64_t t1 = buffer[idx].timestamp;
-                uint64_t t2 = buffer[prevIdx].timestamp;
-                uint64_t c1 = buffer[idx].count;
-                uint64_t c2 = buffer[prevIdx].count;
+                const PCNTCounterSnapshot &s2 = snapshotAt(first, lo + 1);
+                uint64_t t1 = s1.timestamp;
+                uint64_t t2 = s2.timestamp;
+                uint64_t c1 = s1.count;
+                uint64_t c2 = s2.count;
                 if (t2 != t1) {
                     double ratio = (double)(windowStart - t1) / (double)(t2 - t1);
                     startCount = c1 + (uint64_t)((int64_t)(c2 - c1) * ratio);
                 } else {
                     startCount = c1;
                 }
-            } else {
-                startCount = buffer[idx].count;
             }
-            found = true;
-            break;
+        }
+        uint64_t result = (uint64_t)last.count - startCount;
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (sequence.load(std::memory_order_relaxed) == seq) {
+            return result;
         }
     }
-    if (!found) {
-        // Используем самое старое значение
-        startCount = buffer[oldestIdx].count;
-    }
-    uint64_t result = lastCount - startCount;
-    portEXIT_CRITICAL(&spinlock);
-    return result;
 }
 
 // Получение частоты в Гц
@@ -201,6 +234,65 @@ double PCNTFrequencyCounter::getFrequency(uint32_t windowSizeMs) {
     return (double)count * 1000.0 / windowSizeMs;
 }
 
+// Частота по периоду между фронтами в окне
+double PCNTFrequencyCounter::getPeriodFrequency(uint32_t windowSizeMs) {
+    if (!periodCapture) {
+        return 0;
+    }
+    uint64_t copy[PCNT_EDGE_BUFFER];
+    uint32_t n;
+    portENTER_CRITICAL(&spinlock);
+    n = edgesWritten;
+    memcpy(copy, edges, sizeof(copy));
+    portEXIT_CRITICAL(&spinlock);
+    uint64_t currentTime = esp_timer_get_time();
+    uint64_t windowStart = currentTime > windowSizeMs * 1000ULL ? currentTime - (windowSizeMs * 1000ULL) : 0;
+    uint32_t filled = n < PCNT_EDGE_BUFFER ? n : PCNT_EDGE_BUFFER;
+    // Фронты внутри окна, от последнего к первому
+    uint32_t k = 0;
+    uint64_t last = 0, first = 0;
+    for (uint32_t i = 0; i < filled; i++) {
+        uint64_t t = copy[(n - 1 - i) % PCNT_EDGE_BUFFER];
+        if (t < windowStart) {
+            break;
+        }
+        if (k == 0) {
+            last = t;
+        }
+        first = t;
+        k++;
+    }
+    if (k < 2 || last == first) {
+        return 0;
+    }
+    double period = (double)(last - first) / (k - 1);
+    // После последнего фронта прошло больше периода - частота уже не выше 1 / прошедшее время
+    double since = (double)(currentTime - last);
+    if (since > period) {
+        period = since;
+    }
+    return 1000000.0 / period;
+}
+
+// Смешивание частоты по периоду и по счету импульсов
+double PCNTFrequencyCounter::getBlendedFrequency(uint32_t windowSizeMs) {
+    uint64_t count = getCount(windowSizeMs);
+    double counted = (double)count * 1000.0 / windowSizeMs;
+    if (!periodCapture) {
+        return counted;
+    }
+    double measured = getPeriodFrequency(windowSizeMs);
+    if (measured <= 0) {
+        return counted;
+    }
+    // Вес счета растет с числом импульсов, при полном буфере фронтов - только счет
+    double weight = (double)count / PCNT_EDGE_BUFFER;
+    if (weight > 1) {
+        weight = 1;
+    }
+    return weight * counted + (1 - weight) * measured;
+}
+
 // Получение мгновенного значения счетчика
 uint64_t PCNTFrequencyCounter::getCurrentCount() {
     int16_t count;
@@ -210,15 +302,22 @@ uint64_t PCNTFrequencyCounter::getCurrentCount() {
 
 // Сброс счетчика
 void PCNTFrequencyCounter::resetCounter() {
+    // Метки фронтов защищены спинлоком, их писатель - прерывание GPIO
     portENTER_CRITICAL(&spinlock);
-    pcnt_counter_pause(pcntUnit);
-    pcnt_counter_clear(pcntUnit);
-    overflowCount = 0;
-    bufferIndex = 0;
-    bufferFilled = 0;
-    pcnt_counter_resume(pcntUnit);
+    edgesWritten = 0;
     portEXIT_CRITICAL(&spinlock);
+    if (active) {
+        // Буфер пишет только прерывание таймера, сброс выполнит оно
+        resetRequested.store(true, std::memory_order_release);
+    } else {
+        // Таймер экземпляр не опрашивает - других писателей нет
+        applyReset();
+    }
 }
 
 // Статический массив экземпляров
-PCNTFrequencyCounter *PCNTFrequencyCounter::instances[PCNT_UNIT_MAX] = {nullptr};
\ No newline at end of file
+PCNTFrequencyCounter *PCNTFrequencyCounter::instances[PCNT_UNIT_MAX] = {nullptr};
+// Общий таймер
+hw_timer_t *PCNTFrequencyCounter::tmr = NULL;
+uint32_t PCNTFrequencyCounter::tmrPeriodMs = 0;
+int PCNTFrequencyCounter::activeCount = 0;
\ No newline at end of file
@@ -1,14 +1,29 @@
 #pragma once
 
 #include <Arduino.h>
+#include <atomic>
 #include <driver/pcnt.h>
 #include <freertos/FreeRTOS.h>
-#include <freertos/queue.h>
-#include <freertos/task.h>
 
-// Структура для передачи данных через очередь
+// Общий аппаратный таймер всех счетчиков
+#define PCNT_TIMER_NUM 0
+
+// Фронты для подсчета импульсов
+class PCNTEdge {
+  public:
+    static const int Rising = (1 << 0);
+    static const int Falling = (1 << 1);
+    static const int Both = Rising | Falling;
+};
+
+// Емкость буфера меток времени фронтов
+#define PCNT_EDGE_BUFFER 16
+// Минимальный интервал между фронтами (подавление дребезга), мкс
+#define PCNT_EDGE_DEBOUNCE_US 2000
+
+// Снимок счетчика с меткой времени
 struct PCNTCounterSnapshot {
-    uint32_t timestamp;
+    uint64_t timestamp;
     int32_t count;
 };
 
@@ -18,48 +33,74 @@ class PCNTFrequencyCounter {
     gpio_num_t inputPin;
     pcnt_unit_t pcntUnit;
     uint32_t samplePeriodMs;
-    // Циркулярный буфер
+    int edgeMode;
+    uint16_t filterValue;
+    // Циркулярный буфер, писатель - прерывание таймера, читатели без блокировок (seqlock)
     static const int BUFFER_SIZE = 200;
     PCNTCounterSnapshot buffer[BUFFER_SIZE];
-    int bufferIndex;
-    int bufferFilled;
-    // FreeRTOS объекты
-    QueueHandle_t dataQueue;
-    TaskHandle_t processingTask;
-    hw_timer_t *tmr;
+    // Всего записанных снимков, голова буфера = written % BUFFER_SIZE
+    std::atomic<uint32_t> written;
+    // Нечетное значение - писатель обновляет буфер
+    std::atomic<uint32_t> sequence;
+    // Запрос сброса, буфер очищает прерывание таймера - писатель остается единственным
+    std::atomic<bool> resetRequested;
+    // Метки времени последних фронтов, писатель - прерывание GPIO
+    bool periodCapture;
+    uint64_t edges[PCNT_EDGE_BUFFER];
+    volatile uint32_t edgesWritten;
+    // Экземпляр опрашивается общим таймером
+    volatile bool active;
     // Переменные для ISR
     volatile int32_t overflowCount;
     portMUX_TYPE spinlock;
     // Статические указатели для доступа из ISR
     static PCNTFrequencyCounter *instances[PCNT_UNIT_MAX];
+    // Общий таймер для всех экземпляров
+    static hw_timer_t *tmr;
+    static uint32_t tmrPeriodMs;
+    static int activeCount;
     // ISR обработчики
     static void IRAM_ATTR pcntISR(void *arg);
     static void IRAM_ATTR tmrISR();
-    // Фоновая задача обработки данных
-    static void processingTaskFunction(void *parameter);
+    static void IRAM_ATTR edgeISR(void *arg);
     // Настройка
     void initPCNT();
     void initTMR();
+    // Запись снимка в буфер
+    void IRAM_ATTR pushSnapshot(const PCNTCounterSnapshot &snapshot);
+    // Сброс счетчика и буфера на стороне писателя
+    void IRAM_ATTR applyReset();
+    // Снимок по логическому индексу, 0 - самый старый
+    const PCNTCounterSnapshot &snapshotAt(uint32_t first, uint32_t i) const {
+        return buffer[(first + i) % BUFFER_SIZE];
+    }
 
   public:
-    PCNTFrequencyCounter(gpio_num_t pin, pcnt_unit_t unit = PCNT_UNIT_0, uint32_t sampleMs = 100)
-        : inputPin(pin), pcntUnit(unit), samplePeriodMs(sampleMs),
-          bufferIndex(0), bufferFilled(0), overflowCount(0),
-          dataQueue(NULL), processingTask(NULL), tmr(NULL) {
+    // Период опроса задает первый запущенный экземпляр, фильтр помех в тактах APB (до 1023)
+    // Захват меток фронтов нужен для измерения периода на малых частотах
+    PCNTFrequencyCounter(gpio_num_t pin, pcnt_unit_t unit = PCNT_UNIT_0, uint32_t sampleMs = 100, int edge = PCNTEdge::Falling, uint16_t filter = 100, bool capture = false)
+        : inputPin(pin), pcntUnit(unit), samplePeriodMs(sampleMs), edgeMode(edge), filterValue(filter),
+          written(0), sequence(0), resetRequested(false), periodCapture(capture), edgesWritten(0), active(false), overflowCount(0) {
         spinlock = portMUX_INITIALIZER_UNLOCKED;
     }
     ~PCNTFrequencyCounter() {
         end();
     }
-    bool begin(UBaseType_t = 1);
+    bool begin();
     void end();
-    // Получение количества импульсов в скользящем окне
+    // Получение количества импульсов в скользящем окне, O(log n) без блокировок
     uint64_t getCount(uint32_t windowSizeMs);
     // Получение частоты в Гц
     double getFrequency(uint32_t windowSizeMs);
+    // Частота по периоду между фронтами в окне, Гц (0 - менее двух фронтов)
+    double getPeriodFrequency(uint32_t windowSizeMs);
+    // Частота по периоду при малом числе импульсов, по счету - при большом
+    double getBlendedFrequency(uint32_t windowSizeMs);
     // Получение мгновенного значения счетчика
     uint64_t getCurrentCount();
-    // Сброс счетчика
+    // Сброс счетчика, буфер очищается при следующем опросе таймером
     void resetCounter();
+    // Фактический период опроса общим таймером
+    uint32_t getSamplePeriod() { return samplePeriodMs; }
 };
 
@@ -1,11 +1,41 @@
 #include "meteo.h"
+#include "calibrate.h"
 #include "hardware.h"
 
 #define sgn(x) ((x) < 0 ? -1 : ((x) > 0 ? 1 : 0))
 
+void Meteo::setSkyModel() {
+    const float *k = skyModel;
+    skyTerms.c0 = k[2] / 10.;
+    skyTerms.c1 = k[1] / 100.;
+    skyTerms.c3 = k[3] / 100.;
+    // (exp(k4 / 1000 * ta))^(k5 / 100) = exp(k4 * k5 / 100000 * ta)
+    skyTerms.c45 = k[4] * k[5] / 100000.;
+    skyTerms.k6 = k[6];
+    skyTerms.s6 = sgn(k[6]);
+    skyTerms.c7 = k[7] / 100.;
+}
+
 float Meteo::tsky_calc(float ts, float ta) {
-    float t67, td = 0;
-    float k[] = {0., 33., 0., 4., 100., 100., 0., 0.};
+    float d = ta - skyTerms.c0;
+    float td = skyTerms.c1 * d;
+    if (skyTerms.c3 != 0) {
+        td += skyTerms.c3 * expf(skyTerms.c45 * ta);
+    }
+    if (skyTerms.k6 != 0) {
+        float a = fabsf(d);
+        if (a < 1) {
+            td += skyTerms.s6 * sgn(d) * a;
+        } else {
+            td += skyTerms.k6 * sgn(d) * (log10f(a) + skyTerms.c7);
+        }
+    }
+    return ts - td;
+}
+
+double Meteo::tsky_calc_ref(double ts, double ta) {
+    double t67, td = 0;
+    const float *k = skyModel;
     if (abs(k[2] / 10. - ta) < 1) {
         t67 = sgn(k[6]) * sgn(ta - k[2] / 10.) * abs((k[2] / 10. - ta));
     } else {
@@ -15,47 +45,62 @@ float Meteo::tsky_calc(float ts, float ta) {
     return (ts - td);
 }
 
-float Meteo::cb_avg_calc() {
-    int sum = 0;
-    for (int i = 0; i < CB_SIZE; i++)
-        sum += cb[i];
-    return ((float)sum) / CB_SIZE;
+void Meteo::updateSkyNoise(float value) {
+    skyNoise.add(value);
+    // Noise is the sum of squared deviations over the window, SNR relates it to the signal power
+    float m2 = skyNoise.getM2();
+    if (m2 > 0) {
+        sensors.noise_db = 10 * log10(m2);
+        sensors.snr_db = 10 * log10(skyNoise.getPower() / m2);
+    } else {
+        sensors.noise_db = 0;
+        sensors.snr_db = 0;
+    }
 }
 
-float Meteo::cb_rms_calc() {
-    int sum = 0;
-    for (int i = 0; i < CB_SIZE; i++)
-        sum += cb[i] * cb[i];
-    return sqrt(sum / CB_SIZE);
+void Meteo::updateCloudCover() {
+    // Without humidity sensors assume a moderately dry air mass
+    float dewPoint = sensors.mlx_tempamb - 10;
+    if ((HARDWARE_AHT20 && INITED_AHT20) || (HARDWARE_SHT45 && INITED_SHT45)) {
+        dewPoint = sensors.dew_point;
+    }
+    clouds.add(sensors.mlx_tempobj, sensors.mlx_tempamb, dewPoint);
+    sensors.cloud_cover = constrain(calibrate(clouds.getPercent(), CAL_MLX90614_CLOUDCOVER), 0., 100.);
+    sensors.cloud_class = clouds.getClass();
 }
 
-void Meteo::cb_add(float value) {
-    cb[cb_index] = value;
-    cb_avg = cb_avg_calc();
-    cb_rms = cb_rms_calc();
-    cb_noise[cb_index] = abs(value) - cb_rms;
-    cb_index++;
-    if (cb_index == CB_SIZE)
-        cb_index = 0;
+void Meteo::updateTurbulence() {
+    if (skyHighRate) {
+        // Keep the noise dB until the first full FFT frame
+        if (turbulence.compute()) {
+            sensors.turbulence = turbulence.getIndex(skyNoise.getWindow());
+        } else if (!turbulence.ready()) {
+            sensors.turbulence = sensors.noise_db;
+        }
+    } else {
+        sensors.turbulence = sensors.noise_db;
+    }
 }
 
-float Meteo::cb_noise_db_calc() {
-    float n = 0;
-    for (int i = 0; i < CB_SIZE; i++) {
-        n += cb_noise[i] * cb_noise[i];
+void Meteo::setSkyHighRate(bool enable) {
+    if (enable && !turbulence.begin()) {
+        logTechMessage("[TECH][MLX90614] FFT init failed, high rate mode disabled");
+        enable = false;
     }
-    if (n == 0)
-        return 0;
-    return (10 * log10(n));
+    if (enable) {
+        skyHighRateFilter.clear();
+    }
+    skyHighRate = enable;
 }
 
-float Meteo::cb_snr_calc() {
-    float s, n = 0;
-    for (int i = 0; i < CB_SIZE; i++) {
-        s += cb[i] * cb[i];
-        n += cb_noise[i] * cb_noise[i];
-    }
-    if (n == 0)
-        return 0;
-    return (10 * log10(s / n));
+bool Meteo::getSkyHighRate() {
+    return skyHighRate;
+}
+
+void Meteo::setSkyNoiseWindow(int size) {
+    skyNoise.setWindow(size);
+}
+
+int Meteo::getSkyNoiseWindow() {
+    return skyNoise.getWindow();
 }
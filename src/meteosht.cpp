@@ -97,75 +97,235 @@ bool SHT45AutoHeat::begin() {
 
 SHT45Data SHT45AutoHeat::readData() {
     SHT45Data d = {0, 0, false, 0};
+    if (spread && spreadCount > 0) {
+        // measures already spread across the sampling window
+        d.temperature = spreadTemperature / spreadCount;
+        d.humidity = spreadHumidity / spreadCount;
+        d.valid = true;
+        humidity = d.humidity;
+        spreadTemperature = 0;
+        spreadHumidity = 0;
+        spreadCount = 0;
+        return d;
+    }
     if (xSemaphoreTake(semaphore, 0) != pdTRUE) {
         d.error = -1; // heating
         logMessage("[TECH][SHT45] Heating active, skip measure.");
         return d;
     }
-    sht.requestData(SHT4x_MEASUREMENT_SLOW);
+    uint8_t cmd = getPrecisionCommand(precision);
+    float sumTemperature = 0, sumHumidity = 0;
+    int count = 0;
+    for (uint8_t i = 0; i < oversampling; i++) {
+        float t, h;
+        int error = measure(cmd, &t, &h);
+        if (error) {
+            d.error = error;
+            continue;
+        }
+        sumTemperature += t;
+        sumHumidity += h;
+        count++;
+    }
+    xSemaphoreGive(semaphore);
+    if (count > 0) {
+        d.temperature = sumTemperature / count;
+        d.humidity = sumHumidity / count;
+        d.valid = true;
+        humidity = d.humidity;
+    }
+    if (d.error) {
+        logError(d.error);
+    }
+    return d;
+}
+
+bool SHT45AutoHeat::sample() {
+    if (xSemaphoreTake(semaphore, 0) != pdTRUE) {
+        return false;
+    }
+    float t, h;
+    int error = measure(getPrecisionCommand(precision), &t, &h);
+    xSemaphoreGive(semaphore);
+    if (error) {
+        logError(error);
+        return false;
+    }
+    spreadTemperature += t;
+    spreadHumidity += h;
+    spreadCount++;
+    return true;
+}
+
+void SHT45AutoHeat::setPrecision(int p, uint8_t n, bool s) {
+    precision = constrain(p, SHT45Precision::High, SHT45Precision::Low);
+    oversampling = constrain(n, 1, SHT45_MAX_OVERSAMPLING);
+    spread = s;
+    spreadTemperature = 0;
+    spreadHumidity = 0;
+    spreadCount = 0;
+    logMessage("[TECH][SHT45] Precision " + precisionAsString(precision) + ", x" + String(oversampling) + (spread ? ", spread" : ""));
+}
+
+// Single measure, caller must hold the semaphore, busMicros accumulates the I2C transaction time
+int SHT45AutoHeat::measure(uint8_t cmd, float *t, float *h, uint32_t *busMicros) {
+    uint32_t bus = micros();
+    sht.requestData(cmd);
+    if (busMicros) {
+        *busMicros += micros() - bus;
+    }
+    // sleep the whole conversion time instead of polling the bus
+    vTaskDelay(pdMS_TO_TICKS(getMeasureDuration(cmd)));
     uint32_t start = millis();
     while (!sht.dataReady() && millis() - start < 20) {
         vTaskDelay(pdMS_TO_TICKS(1));
     }
     if (!sht.dataReady()) {
-        d.error = -2; // timeout
-        xSemaphoreGive(semaphore);
-        logMessage("[TECH][SHT45] Timeout error!");
-        return d;
+        return -2; // timeout
+    }
+    bus = micros();
+    bool read = sht.readData(true);
+    if (busMicros) {
+        *busMicros += micros() - bus;
+    }
+    if (!read) {
+        return sht.getError();
+    }
+    *t = sht.getTemperature();
+    *h = sht.getHumidity();
+    if (isnan(*t) || isnan(*h)) {
+        return sht.getError() ? sht.getError() : -3;
     }
-    if (sht.readData(true)) {
-        d.temperature = sht.getTemperature();
-        d.humidity = sht.getHumidity();
-        d.valid = !isnan(d.temperature) && !isnan(d.humidity);
-        if (d.valid) {
-            humidity = d.humidity;
+    return 0;
+}
+
+bool SHT45AutoHeat::runReport(int samples) {
+    if (samples < 2) {
+        samples = 2;
+    }
+    if (xSemaphoreTake(semaphore, pdMS_TO_TICKS(1000)) != pdTRUE) {
+        logMessage("[TECH][SHT45] Heating active, skip report.");
+        return false;
+    }
+    for (int p = SHT45Precision::High; p <= SHT45Precision::Low; p++) {
+        uint8_t cmd = getPrecisionCommand(p);
+        // Welford running variance
+        float meanT = 0, m2T = 0, meanH = 0, m2H = 0;
+        uint32_t busMicros = 0;
+        int n = 0;
+        for (int i = 0; i < samples; i++) {
+            float t, h;
+            // Request and read transactions only, not the conversion sleep
+            uint32_t bus = 0;
+            int error = measure(cmd, &t, &h, &bus);
+            if (error) {
+                continue;
+            }
+            n++;
+            busMicros += bus;
+            float delta = t - meanT;
+            meanT += delta / n;
+            m2T += delta * (t - meanT);
+            delta = h - meanH;
+            meanH += delta / n;
+            m2H += delta * (h - meanH);
         }
-        d.error = sht.getError();
-    } else {
-        d.error = sht.getError();
+        report[p].samples = n;
+        report[p].busMicros = n > 0 ? busMicros / n : 0;
+        report[p].temperatureNoise = n > 1 ? sqrt(m2T / (n - 1)) : NAN;
+        report[p].humidityNoise = n > 1 ? sqrt(m2H / (n - 1)) : NAN;
     }
     xSemaphoreGive(semaphore);
-    if (d.error) {
-        switch (d.error) {
-        case SHT4x_OK:
-            logMessage("[TECH][SHT45] No error occurred (you shouldn't see this)");
-            break;
-        case SHT4x_ERR_WRITECMD:
-            logMessage("[TECH][SHT45] Write command error!");
-            break;
-        case SHT4x_ERR_READBYTES:
-            logMessage("[TECH][SHT45] Read bytes error!");
-            break;
-        case SHT4x_ERR_HEATER_OFF:
-            logMessage("[TECH][SHT45] Heater off error!");
-            break;
-        case SHT4x_ERR_NOT_CONNECT:
-            logMessage("[TECH][SHT45] Not connected error!");
-            break;
-        case SHT4x_ERR_CRC_TEMP:
-            logMessage("[TECH][SHT45] Temperature CRC error!");
-            break;
-        case SHT4x_ERR_CRC_HUM:
-            logMessage("[TECH][SHT45] Humidity CRC error!");
-            break;
-        case SHT4x_ERR_HEATER_COOLDOWN:
-            logMessage("[TECH][SHT45] Heater cooldown error!");
-            break;
-        case SHT4x_ERR_HEATER_ON:
-            logMessage("[TECH][SHT45] Heater on error!");
-            break;
-        case SHT4x_ERR_SERIAL_NUMBER_CRC:
-            logMessage("[TECH][SHT45] Serial number CRC error!");
-            break;
-        case 0x8B:
-            logMessage("[TECH][SHT45] Invalid address error!");
-            break;
-        default:
-            logMessage("[TECH][SHT45] Unknown error (you shouldn't see this)");
-            break;
-        }
+    return true;
+}
+
+SHT45Report SHT45AutoHeat::getReport(int p) {
+    return report[constrain(p, SHT45Precision::High, SHT45Precision::Low)];
+}
+
+void SHT45AutoHeat::logError(int error) {
+    switch (error) {
+    case -2:
+        logMessage("[TECH][SHT45] Timeout error!");
+        break;
+    case -3:
+        logMessage("[TECH][SHT45] Invalid data error!");
+        break;
+    case SHT4x_OK:
+        logMessage("[TECH][SHT45] No error occurred (you shouldn't see this)");
+        break;
+    case SHT4x_ERR_WRITECMD:
+        logMessage("[TECH][SHT45] Write command error!");
+        break;
+    case SHT4x_ERR_READBYTES:
+        logMessage("[TECH][SHT45] Read bytes error!");
+        break;
+    case SHT4x_ERR_HEATER_OFF:
+        logMessage("[TECH][SHT45] Heater off error!");
+        break;
+    case SHT4x_ERR_NOT_CONNECT:
+        logMessage("[TECH][SHT45] Not connected error!");
+        break;
+    case SHT4x_ERR_CRC_TEMP:
+        logMessage("[TECH][SHT45] Temperature CRC error!");
+        break;
+    case SHT4x_ERR_CRC_HUM:
+        logMessage("[TECH][SHT45] Humidity CRC error!");
+        break;
+    case SHT4x_ERR_HEATER_COOLDOWN:
+        logMessage("[TECH][SHT45] Heater cooldown error!");
+        break;
+    case SHT4x_ERR_HEATER_ON:
+        logMessage("[TECH][SHT45] Heater on error!");
+        break;
+    case SHT4x_ERR_SERIAL_NUMBER_CRC:
+        logMessage("[TECH][SHT45] Serial number CRC error!");
+        break;
+    case 0x8B:
+        logMessage("[TECH][SHT45] Invalid address error!");
+        break;
+    default:
+        logMessage("[TECH][SHT45] Unknown error (you shouldn't see this)");
+        break;
+    }
+}
+
+String SHT45AutoHeat::precisionAsString(int p) {
+    switch (p) {
+    case SHT45Precision::High:
+        return "high";
+    case SHT45Precision::Medium:
+        return "medium";
+    case SHT45Precision::Low:
+        return "low";
+    default:
+        return "";
+    }
+}
+
+uint8_t SHT45AutoHeat::getPrecisionCommand(int p) {
+    switch (p) {
+    case SHT45Precision::Medium:
+        return SHT4x_MEASUREMENT_MEDIUM;
+    case SHT45Precision::Low:
+        return SHT4x_MEASUREMENT_FAST;
+    default:
+        return SHT4x_MEASUREMENT_SLOW;
+    }
+}
+
+// Maximum conversion time from the SHT4x datasheet, ms
+uint32_t SHT45AutoHeat::getMeasureDuration(uint8_t cmd) {
+    switch (cmd) {
+    case SHT4x_MEASUREMENT_SLOW:
+        return 9;
+    case SHT4x_MEASUREMENT_MEDIUM:
+        return 5;
+    case SHT4x_MEASUREMENT_FAST:
+        return 2;
+    default:
+        return getHeatDuration(cmd);
     }
-    return d;
 }
 
 String SHT45AutoHeat::cmdAsString(uint8_t command) {
@@ -220,6 +380,7 @@ void SHT45AutoHeat::heatingTask() {
             logMessage("[TECH][SHT45] Begin heating on humidity " + String(humidity, 0) + "%, after " + String(interval / (60 * 1000)) + "m, " + cmdAsString(p->cmd) + ", x" + String(p->cycles) + ", cooldown " + String(p->cooldown / 1000) + "s");
             vTaskDelay(pdMS_TO_TICKS(500));
             xSemaphoreTake(semaphore, portMAX_DELAY);
+            heating = true;
             for (uint8_t i = 0; i < p->cycles; i++) {
                 logMessage("[TECH][SHT45] Heating cycle #" + String(i + 1) + "...");
                 doHeat(p->cmd);
@@ -235,6 +396,7 @@ void SHT45AutoHeat::heatingTask() {
             vTaskDelay(pdMS_TO_TICKS(p->cooldown));
             logMessage("[TECH][SHT45] Cooldown done, heating complete.");
             updateHumidity();
+            heating = false;
             xSemaphoreGive(semaphore);
         }
         vTaskDelay(pdMS_TO_TICKS(1000));
@@ -252,15 +414,9 @@ void SHT45AutoHeat::doHeat(uint8_t cmd) {
 }
 
 void SHT45AutoHeat::updateHumidity() {
-    sht.requestData(SHT4x_MEASUREMENT_SLOW);
-    uint32_t start = millis();
-    while (!sht.dataReady() && millis() - start < 20) {
-        vTaskDelay(pdMS_TO_TICKS(1));
-    }
-    if (sht.readData(true)) {
-        float h = sht.getHumidity();
-        if (!isnan(h))
-            humidity = h;
+    float t, h;
+    if (measure(SHT4x_MEASUREMENT_SLOW, &t, &h) == 0) {
+        humidity = h;
     }
 }
 
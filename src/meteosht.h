@@ -4,6 +4,16 @@
 #include <Arduino.h>
 #include <Wire.h>
 
+#define SHT45_MAX_OVERSAMPLING 16
+#define SHT45_REPORT_SAMPLES 16
+
+class SHT45Precision {
+  public:
+    static const int High = 0;
+    static const int Medium = 1;
+    static const int Low = 2;
+};
+
 struct SHT45Data {
     float temperature;
     float humidity;
@@ -11,6 +21,14 @@ struct SHT45Data {
     int error; // 0 = no error
 };
 
+// Measured noise (standard deviation) and I2C bus time of a single measure
+struct SHT45Report {
+    float temperatureNoise;
+    float humidityNoise;
+    uint32_t busMicros;
+    int samples;
+};
+
 struct HeatingParams {
     float humMin, humMax;
     uint32_t intervalMin, intervalMax;
@@ -26,6 +44,19 @@ class SHT45AutoHeat {
 
     bool begin();
     SHT45Data readData();
+    // Take one measure into the spread accumulator
+    bool sample();
+    // Precision, number of measures per reading, spread measures across the sampling window
+    void setPrecision(int precision, uint8_t oversampling = 1, bool spread = false);
+    int getPrecision() { return precision; }
+    uint8_t getOversampling() { return oversampling; }
+    bool isSpread() { return spread; }
+    // Heater or its cooldown active, readings are biased
+    bool isHeating() { return heating; }
+    // Measure noise and bus time of every precision mode
+    bool runReport(int samples = SHT45_REPORT_SAMPLES);
+    SHT45Report getReport(int precision);
+    String precisionAsString(int precision);
 
     void setLogger(const int source, std::function<void(String, const int)> logLineCallback = nullptr, std::function<void(String, const int)> logLinePartCallback = nullptr, std::function<String()> logTimeCallback = nullptr);
 
@@ -36,6 +67,15 @@ class SHT45AutoHeat {
     volatile float humidity;
     uint32_t lastHeat;
     uint32_t nextAllowed;
+    volatile bool heating = false;
+
+    int precision = SHT45Precision::High;
+    uint8_t oversampling = 1;
+    bool spread = false;
+    float spreadTemperature = 0;
+    float spreadHumidity = 0;
+    int spreadCount = 0;
+    SHT45Report report[3] = {};
 
     static const HeatingParams table[5];
 
@@ -45,6 +85,10 @@ class SHT45AutoHeat {
     void updateHumidity();
     const HeatingParams *getParams(float h);
     uint32_t getHeatDuration(uint8_t cmd);
+    int measure(uint8_t cmd, float *t, float *h, uint32_t *busMicros = nullptr);
+    uint8_t getPrecisionCommand(int precision);
+    uint32_t getMeasureDuration(uint8_t cmd);
+    void logError(int error);
 
     std::function<void(String, const int)> logLine = nullptr;
     std::function<void(String, const int)> logLinePart = nullptr;
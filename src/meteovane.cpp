@@ -0,0 +1,140 @@
+#include "meteovane.h"
+
+// Ladder resistance per 22.5° position, Ohm (Argent 80422 / SparkFun vane)
+static const float VANE_RESISTANCE[VANE_POSITIONS] = {
+    33000, 6570, 8200, 891, 1000, 688, 2200, 1410,
+    3900, 3140, 16000, 14120, 120000, 42120, 64900, 21880};
+
+void ADCWindVane::logMessage(String msg, bool showtime) {
+    if (logLine && logLinePart) {
+        if (logTime && showtime) {
+            logLinePart(logTime() + " ", logSource);
+        }
+        logLine(msg, logSource);
+    }
+}
+
+void ADCWindVane::setLogger(const int logSrc, std::function<void(String, const int)> logLineCallback, std::function<void(String, const int)> logLinePartCallback, std::function<String()> logTimeCallback) {
+    logSource = logSrc;
+    logLine = logLineCallback;
+    logLinePart = logLinePartCallback;
+    logTime = logTimeCallback;
+}
+
+bool ADCWindVane::begin() {
+    for (int i = 0; i < VANE_POSITIONS; i++) {
+        ladder[i] = WIND_VANE_SUPPLY_MV * VANE_RESISTANCE[i] / (VANE_RESISTANCE[i] + WIND_VANE_PULLUP);
+    }
+    esp_adc_cal_characterize(ADC_UNIT_1, ADC_ATTEN_DB_11, ADC_WIDTH_BIT_12, 1100, &adcChars);
+    adc_digi_init_config_t init = {
+        .max_store_buf_size = VANE_FRAME_BYTES * 4,
+        .conv_num_each_intr = VANE_FRAME_BYTES,
+        .adc1_chan_mask = (uint32_t)BIT(channel),
+        .adc2_chan_mask = 0,
+    };
+    esp_err_t err = adc_digi_initialize(&init);
+    if (err != ESP_OK) {
+        logMessage("[TECH][VANE] ADC DMA init failed: " + String(esp_err_to_name(err)));
+        return false;
+    }
+    adc_digi_pattern_config_t pattern = {
+        .atten = ADC_ATTEN_DB_11,
+        .channel = (uint8_t)channel,
+        .unit = 0,
+        .bit_width = SOC_ADC_DIGI_MAX_BITWIDTH,
+    };
+    adc_digi_configuration_t config = {
+        .conv_limit_en = false,
+        .conv_limit_num = 250,
+        .pattern_num = 1,
+        .adc_pattern = &pattern,
+        .sample_freq_hz = VANE_SAMPLE_FREQ,
+        .conv_mode = ADC_CONV_SINGLE_UNIT_1,
+        .format = ADC_DIGI_OUTPUT_FORMAT_TYPE2,
+    };
+    err = adc_digi_controller_configure(&config);
+    if (err == ESP_OK) {
+        err = adc_digi_start();
+    }
+    if (err != ESP_OK) {
+        logMessage("[TECH][VANE] ADC DMA start failed: " + String(esp_err_to_name(err)));
+        adc_digi_deinitialize();
+        return false;
+    }
+    running = true;
+    return true;
+}
+
+void ADCWindVane::end() {
+    if (running) {
+        adc_digi_stop();
+        adc_digi_deinitialize();
+        running = false;
+    }
+}
+
+int ADCWindVane::decode(uint32_t mv) {
+    int best = 0;
+    float bestDiff = fabsf(mv - ladder[0]);
+    for (int i = 1; i < VANE_POSITIONS; i++) {
+        float diff = fabsf(mv - ladder[i]);
+        if (diff < bestDiff) {
+            bestDiff = diff;
+            best = i;
+        }
+    }
+    return best;
+}
+
+bool ADCWindVane::update(float speed) {
+    if (!running) {
+        return false;
+    }
+    // Oversampling - average everything DMA collected since the last update
+    uint8_t frame[VANE_FRAME_BYTES];
+    uint32_t length = 0;
+    uint32_t sum = 0;
+    uint32_t count = 0;
+    while (adc_digi_read_bytes(frame, VANE_FRAME_BYTES, &length, 0) == ESP_OK && length > 0) {
+        for (uint32_t i = 0; i + SOC_ADC_DIGI_RESULT_BYTES <= length; i += SOC_ADC_DIGI_RESULT_BYTES) {
+            adc_digi_output_data_t *p = (adc_digi_output_data_t *)&frame[i];
+            if (p->type2.unit == 0 && p->type2.channel == channel) {
+                sum += p->type2.data;
+                count++;
+            }
+        }
+    }
+    if (count == 0) {
+        return false;
+    }
+    samples = count;
+    voltage = esp_adc_cal_raw_to_voltage(sum / count, &adcChars);
+    position = decode(voltage);
+    // Speed-weighted unit vector, calm still counts a little to keep the direction alive
+    float angle = position * 22.5 * DEG_TO_RAD;
+    float weight = speed > 0 ? speed : 0.01;
+    if (filled == VANE_AVERAGE_SIZE) {
+        sumX -= vx[head];
+        sumY -= vy[head];
+    } else {
+        filled++;
+    }
+    vx[head] = weight * sinf(angle);
+    vy[head] = weight * cosf(angle);
+    sumX += vx[head];
+    sumY += vy[head];
+    head = (head + 1) % VANE_AVERAGE_SIZE;
+    return true;
+}
+
+float ADCWindVane::getDirection() {
+    if (filled == 0) {
+        return 0;
+    }
+    float direction = atan2f(sumX, sumY) * RAD_TO_DEG;
+    return direction < 0 ? direction + 360 : direction;
+}
+
+float ADCWindVane::getInstantDirection() {
+    return position < 0 ? 0 : position * 22.5;
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+#include "config.h"
+#include <Arduino.h>
+#include <driver/adc.h>
+#include <esp_adc_cal.h>
+#include <functional>
+
+// Continuous ADC sampling rate, Hz (DMA, no CPU polling)
+#define VANE_SAMPLE_FREQ 1000
+// DMA frame size, bytes (4 bytes per conversion)
+#define VANE_FRAME_BYTES 256
+// Resistor ladder positions
+#define VANE_POSITIONS 16
+// Vector averaging window in updates
+#define VANE_AVERAGE_SIZE 12
+
+// Wind vane on a resistor ladder read by the continuous (DMA) ADC
+class ADCWindVane {
+  private:
+    adc1_channel_t channel;
+    esp_adc_cal_characteristics_t adcChars;
+    bool running = false;
+    // Ladder divider voltages, mV
+    float ladder[VANE_POSITIONS];
+    // Last decoded position, -1 - none yet
+    int position = -1;
+    // Last oversampled voltage, mV
+    uint32_t voltage = 0;
+    uint32_t samples = 0;
+    // Speed-weighted unit vectors for the averaging window
+    float vx[VANE_AVERAGE_SIZE] = {0};
+    float vy[VANE_AVERAGE_SIZE] = {0};
+    float sumX = 0, sumY = 0;
+    int head = 0;
+    int filled = 0;
+    // Log
+    std::function<void(String, const int)> logLine = nullptr;
+    std::function<void(String, const int)> logLinePart = nullptr;
+    std::function<String()> logTime = nullptr;
+    int logSource;
+    void logMessage(String msg, bool showtime = true);
+    // Nearest ladder position for the voltage
+    int decode(uint32_t mv);
+
+  public:
+    ADCWindVane(adc1_channel_t ch = WIND_VANE_CHANNEL) : channel(ch) {}
+    bool begin();
+    void end();
+    // Drain DMA frames, decode direction and add it weighted by wind speed
+    bool update(float speed);
+    // Vector averaged direction in degrees 0..360
+    float getDirection();
+    // Last decoded direction in degrees
+    float getInstantDirection();
+    uint32_t getVoltage() { return voltage; }
+    uint32_t getSamples() { return samples; }
+    // Set current logger
+    void setLogger(const int source, std::function<void(String, const int)> logLineCallback = nullptr, std::function<void(String, const int)> logLinePartCallback = nullptr, std::function<String()> logTimeCallback = nullptr);
+};
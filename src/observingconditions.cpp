@@ -38,154 +38,232 @@ void ObservingConditions::setImmediateUpdate(std::function<void()> immediateUpda
 
 bool ObservingConditions::begin() {
     _observingconditions_array[_observingconditions_index] = this;
-    _averaging = _avgperiod / _refresh;
-    if (_averaging == 0) {
-        _averaging = 1;
-    }
     return true;
 }
 
 void ObservingConditions::update(Meteo* meteo) {
-    String message = "[OBSERVING][DATA]";
+    // Markers are only touched here, a reset in the middle of an add breaks them
+    if (_quantile_reset_requested) {
+        resetQuantiles();
+        _quantile_reset_requested = false;
+    }
+    rainrate = OBSCON_RAINRATE ? meteo->sensors.rain_rate : 0;
+    rainrate_ts.add(rainrate);
+    temperature = OBSCON_TEMPERATURE ? meteo->sensors.temperature : 0;
+    temperature_ts.add(temperature);
+    humidity = OBSCON_HUMIDITY ? meteo->sensors.humidity : 0;
+    humidity_ts.add(humidity);
+    pressure = OBSCON_PRESSURE ? meteo->sensors.bmp_pressure : 0;
+    pressure_ts.add(pressure);
+    dewpoint = OBSCON_DEWPOINT ? meteo->sensors.dew_point : 0;
+    dewpoint_ts.add(dewpoint);
+    skytemp = OBSCON_SKYTEMP ? meteo->sensors.sky_temperature : 0;
+    skytemp_ts.add(skytemp);
+    if (meteo->getSkyHighRate() != _turbulence_highrate) {
+        // Do not average the FFT index with the noise dB across a mode change
+        noisedb_ts.clear();
+        _turbulence_highrate = meteo->getSkyHighRate();
+    }
+    noisedb = OBSCON_FWHM ? meteo->sensors.turbulence : 0;
+    noisedb_ts.add(noisedb);
+    cloudcover = OBSCON_CLOUDCOVER ? meteo->sensors.cloud_cover : 0;
+    if (OBSCON_CLOUDCOVER) {
+        cloudclass = meteo->sensors.cloud_class;
+    }
+    cloudcover_ts.add(cloudcover);
+    skyquality = OBSCON_SKYQUALITY ? meteo->sensors.sky_quality : 0;
+    skyquality_ts.add(skyquality);
+    skybrightness = OBSCON_SKYBRIGHTNESS ? meteo->sensors.sky_brightness : 0;
+    skybrightness_ts.add(skybrightness);
+    winddir = OBSCON_WINDDIR ? meteo->sensors.wind_direction : 0;
+    float weight = OBSCON_WINDDIR ? (OBSCON_WINDSPEED ? meteo->sensors.wind_speed : 1) : 0;
+    winddir_x_ts.add(weight * sinf(winddir * DEG_TO_RAD));
+    winddir_y_ts.add(weight * cosf(winddir * DEG_TO_RAD));
+    windspeed = OBSCON_WINDSPEED ? meteo->sensors.wind_speed : 0;
+    windspeed_ts.add(windspeed);
+    windgust = OBSCON_WINDGUST ? meteo->sensors.wind_gust : 0;
+    windgust_ts.add(windgust);
+    pressure_tendency_1h = meteo->sensors.pressure_tendency_1h;
+    pressure_tendency_3h = meteo->sensors.pressure_tendency_3h;
+    temperature_trend = meteo->sensors.temperature_trend;
+    humidity_trend = meteo->sensors.humidity_trend;
+    skytemp_trend = meteo->sensors.sky_temperature_trend;
+
+    uint32_t period = quantileResetPeriod(_quantile_reset);
+    if (period != _quantile_period) {
+        resetQuantiles();
+        _quantile_period = period;
+    }
+    if (OBSCON_WINDSPEED) {
+        windspeed_q.add(windspeed);
+    }
+    if (OBSCON_SKYTEMP) {
+        skytemp_q.add(skytemp);
+    }
+    if (OBSCON_SKYQUALITY) {
+        skyquality_q.add(skyquality);
+    }
+
+    timelastupdate = millis();
+    updateAverages();
 
+    String message = "[OBSERVING][DATA]";
     if (OBSCON_RAINRATE) {
-        rainrate = meteo->sensors.rain_rate;
-        rainrate_ra.add(rainrate);
-        message += " RR:" + String(rainrate, 2) + "/" + String(rainrate_ra.getAverageLast(_averaging > rainrate_ra.getCount() ? rainrate_ra.getCount() : _averaging), 2);
+        message += " RR:" + String(rainrate, 2) + "/" + String(averaged.rainrate, 2);
     } else {
-        rainrate = 0;
-        rainrate_ra.add(rainrate);
         message += " RR:-";
     }
 
     if (OBSCON_TEMPERATURE) {
-        temperature = meteo->sensors.temperature;
-        temperature_ra.add(temperature);
-        message += " T:" + String(temperature, 1) + "/" + String(temperature_ra.getAverageLast(_averaging > temperature_ra.getCount() ? temperature_ra.getCount() : _averaging), 1);
+        message += " T:" + String(temperature, 1) + "/" + String(averaged.temperature, 1);
     } else {
-        temperature = 0;
-        temperature_ra.add(temperature);
         message += " T:-";
     }
 
     if (OBSCON_HUMIDITY) {
-        humidity = meteo->sensors.humidity;
-        humidity_ra.add(humidity);
-        message += " H:" + String(humidity, 0) + "/" + String(humidity_ra.getAverageLast(_averaging > humidity_ra.getCount() ? humidity_ra.getCount() : _averaging), 0);
+        message += " H:" + String(humidity, 0) + "/" + String(averaged.humidity, 0);
     } else {
-        humidity = 0;
-        humidity_ra.add(humidity);
         message += " H:-";
     }
 
     if (OBSCON_PRESSURE) {
-        pressure = meteo->sensors.bmp_pressure;
-        pressure_ra.add(pressure);
-        message += " P:" + String(pressure, 0) + "/" + String(pressure_ra.getAverageLast(_averaging > pressure_ra.getCount() ? pressure_ra.getCount() : _averaging), 0);
+        message += " P:" + String(pressure, 0) + "/" + String(averaged.pressure, 0);
     } else {
-        pressure = 0;
-        pressure_ra.add(pressure);
         message += " P:-";
     }
 
     if (OBSCON_DEWPOINT) {
-        dewpoint = meteo->sensors.dew_point;
-        dewpoint_ra.add(dewpoint);
-        message += " DP:" + String(dewpoint, 1) + "/" + String(dewpoint_ra.getAverageLast(_averaging > dewpoint_ra.getCount() ? dewpoint_ra.getCount() : _averaging), 1);
+        message += " DP:" + String(dewpoint, 1) + "/" + String(averaged.dewpoint, 1);
     } else {
-        dewpoint = 0;
-        dewpoint_ra.add(dewpoint);
         message += " DP:-";
     }
 
     if (OBSCON_SKYTEMP) {
-        skytemp = meteo->sensors.sky_temperature;
-        skytemp_ra.add(skytemp);
-        message += " ST:" + String(skytemp, 1) + "/" + String(skytemp_ra.getAverageLast(_averaging > skytemp_ra.getCount() ? skytemp_ra.getCount() : _averaging), 1);
+        message += " ST:" + String(skytemp, 1) + "/" + String(averaged.skytemp, 1);
     } else {
-        skytemp = 0;
-        skytemp_ra.add(skytemp);
         message += " ST:-";
     }
 
     if (OBSCON_FWHM) {
-        noisedb = meteo->sensors.noise_db;
-        noisedb_ra.add(noisedb);
-        message += " TR:" + String(noisedb, 1) + "/" + String(noisedb_ra.getAverageLast(_averaging > noisedb_ra.getCount() ? noisedb_ra.getCount() : _averaging), 1);
+        message += " TR:" + String(noisedb, 1) + "/" + String(averaged.noisedb, 1);
     } else {
-        noisedb = 0;
-        noisedb_ra.add(noisedb);
         message += " TR:-";
     }
 
     if (OBSCON_CLOUDCOVER) {
-        cloudcover = meteo->sensors.cloud_cover;
-        cloudcover_ra.add(cloudcover);
-        message += " CC:" + String(cloudcover, 0) + "/" + String(cloudcover_ra.getAverageLast(_averaging > cloudcover_ra.getCount() ? cloudcover_ra.getCount() : _averaging), 0);
+        message += " CC:" + String(cloudcover, 0) + "/" + String(averaged.cloudcover, 0);
     } else {
-        cloudcover = 0;
-        cloudcover_ra.add(cloudcover);
         message += " CC:-";
     }
 
     if (OBSCON_SKYQUALITY) {
-        skyquality = meteo->sensors.sky_quality;
-        skyquality_ra.add(skyquality);
-        message += " SQ:" + String(skyquality, 1) + "/" + String(skyquality_ra.getAverageLast(_averaging > skyquality_ra.getCount() ? skyquality_ra.getCount() : _averaging), 1);
+        message += " SQ:" + String(skyquality, 1) + "/" + String(averaged.skyquality, 1);
     } else {
-        skyquality = 0;
-        skyquality_ra.add(skyquality);
         message += " SQ:-";
     }
 
     if (OBSCON_SKYBRIGHTNESS) {
-        skybrightness = meteo->sensors.sky_brightness;
-        skybrightness_ra.add(skybrightness);
-        message += " SB:" + smart_round(skybrightness) + "/" + smart_round(skybrightness_ra.getAverageLast(_averaging > skybrightness_ra.getCount() ? skybrightness_ra.getCount() : _averaging));
+        message += " SB:" + smart_round(skybrightness) + "/" + smart_round(averaged.skybrightness);
     } else {
-        skybrightness = 0;
-        skybrightness_ra.add(skybrightness);
         message += " SB:-";
     }
 
     if (OBSCON_WINDDIR) {
-        winddir = meteo->sensors.wind_direction;
-        winddir_ra.add(winddir);
-        message += " WD:" + String(winddir, 1) + "/" + String(winddir_ra.getAverageLast(_averaging > winddir_ra.getCount() ? winddir_ra.getCount() : _averaging), 1);
+        message += " WD:" + String(winddir, 0) + "/" + String(averaged.winddir, 0);
     } else {
-        winddir = 0;
-        winddir_ra.add(winddir);
         message += " WD:-";
     }
 
     if (OBSCON_WINDSPEED) {
-        windspeed = meteo->sensors.wind_speed;
-        windspeed_ra.add(windspeed);
-        message += " WS:" + String(windspeed, 1) + "/" + String(windspeed_ra.getAverageLast(_averaging > windspeed_ra.getCount() ? windspeed_ra.getCount() : _averaging), 1);
+        message += " WS:" + String(windspeed, 1) + "/" + String(averaged.windspeed, 1);
     } else {
-        windspeed = 0;
-        windspeed_ra.add(windspeed);
         message += " WS:-";
     }
 
     if (OBSCON_WINDGUST) {
-        windgust = meteo->sensors.wind_gust;
-        windgust_ra.add(windgust);
-        message += " WG:" + String(windgust, 1) + "/" + String(windgust_ra.getAverageLast(_averaging > windgust_ra.getCount() ? windgust_ra.getCount() : _averaging), 1);
+        message += " WG:" + String(windgust, 1) + "/" + String(averaged.windgust, 1);
     } else {
-        windgust = 0;
-        windgust_ra.add(windgust);
         message += " WG:-";
     }
 
-    timelastupdate = millis();
-
     if (logEnabled[LogSource::ObsCon] == Log::On || (logEnabled[LogSource::ObsCon] == Log::Slow && millis() - last_message > logSlow[LogSource::ObsCon] * 1000)) {
         logMessage(message);
+        logMessage("[OBSERVING][QUANTILES] " + quantilesAsString());
         last_message = millis();
     }
 };
 
+void ObservingConditions::updateAverages() {
+    averaged.rainrate = average(rainrate_ts, ObsconChannel::RainRate);
+    averaged.temperature = average(temperature_ts, ObsconChannel::Temperature);
+    averaged.humidity = average(humidity_ts, ObsconChannel::Humidity);
+    averaged.pressure = average(pressure_ts, ObsconChannel::Pressure);
+    averaged.dewpoint = average(dewpoint_ts, ObsconChannel::DewPoint);
+    averaged.skytemp = average(skytemp_ts, ObsconChannel::SkyTemperature);
+    averaged.noisedb = average(noisedb_ts, ObsconChannel::Turbulence);
+    averaged.cloudcover = average(cloudcover_ts, ObsconChannel::CloudCover);
+    averaged.skyquality = average(skyquality_ts, ObsconChannel::SkyQuality);
+    averaged.skybrightness = average(skybrightness_ts, ObsconChannel::SkyBrightness);
+    averaged.winddir = averageWindDirection();
+    averaged.windspeed = average(windspeed_ts, ObsconChannel::WindSpeed);
+    averaged.windgust = average(windgust_ts, ObsconChannel::WindGust);
+}
+
+void ObservingConditions::checkpoint(ObsconCheckpoint *cp) {
+    for (int i = 0; i < OBSCON_SERIES; i++) {
+        _series[i]->checkpoint(&cp->series[i]);
+    }
+    cp->turbulence_highrate = _turbulence_highrate;
+}
+
+void ObservingConditions::restore(const ObsconCheckpoint *cp, uint32_t age) {
+    for (int i = 0; i < OBSCON_SERIES; i++) {
+        _series[i]->restore(&cp->series[i], age);
+    }
+    _turbulence_highrate = cp->turbulence_highrate;
+    updateAverages();
+}
+
+void ObservingConditions::resetQuantiles() {
+    windspeed_q.clear();
+    skytemp_q.clear();
+    skyquality_q.clear();
+}
+
+String ObservingConditions::quantilesAsString() {
+    String message = "WS:" + (OBSCON_WINDSPEED ? windspeed_q.asString(1) : String("-"));
+    message += " ST:" + (OBSCON_SKYTEMP ? skytemp_q.asString(1) : String("-"));
+    message += " SQ:" + (OBSCON_SKYQUALITY ? skyquality_q.asString(2) : String("-"));
+    return message;
+}
+
+String ObservingConditions::trendAsString(bool enabled, float value, unsigned int decimals) {
+    if (!enabled || std::isnan(value)) {
+        return "n/a";
+    }
+    return (value > 0 ? "+" : "") + String(value, decimals);
+}
+
+float ObservingConditions::average(TimeSeries &ts, int channel) {
+    // EMA time constant follows AveragePeriod from the next sample
+    ts.setEmaPeriod(_avgperiod);
+    return ts.getAverage(_kernel[channel], _avgperiod);
+}
+
+float ObservingConditions::averageWindDirection() {
+    if (winddir_x_ts.getCount() == 0) {
+        return 0;
+    }
+    float x = winddir_x_ts.getMean(_avgperiod);
+    float y = winddir_y_ts.getMean(_avgperiod);
+    // Calm - no direction (ASCOM reports 0)
+    if (x == 0 && y == 0) {
+        return 0;
+    }
+    float direction = atan2f(x, y) * RAD_TO_DEG;
+    return direction < 0 ? direction + 360 : direction;
+}
+
 void ObservingConditions::aGetDescription(AsyncWebServerRequest *request) {
     String description = "DreamSky Observing Conditions Monitor";
     _alpacaServer->respond(request, description.c_str());
@@ -215,8 +293,7 @@ void ObservingConditions::aGetAveragePeriod(AsyncWebServerRequest *request) {
 
 void ObservingConditions::aGetRainRate(AsyncWebServerRequest *request) {
     if (OBSCON_RAINRATE) {
-        float value = rainrate_ra.getAverageLast(
-            _averaging > rainrate_ra.getCount() ? rainrate_ra.getCount() : _averaging);
+        float value = averaged.rainrate;
         value = round(100. * value) / 100.;
         _alpacaServer->respond(request, value);
     } else {
@@ -226,8 +303,7 @@ void ObservingConditions::aGetRainRate(AsyncWebServerRequest *request) {
 
 void ObservingConditions::aGetTemperature(AsyncWebServerRequest *request) {
     if (OBSCON_TEMPERATURE) {
-        float value = temperature_ra.getAverageLast(
-            _averaging > temperature_ra.getCount() ? temperature_ra.getCount() : _averaging);
+        float value = averaged.temperature;
         value = round(10. * value) / 10.;
         _alpacaServer->respond(request, value);
     } else {
@@ -237,8 +313,7 @@ void ObservingConditions::aGetTemperature(AsyncWebServerRequest *request) {
 
 void ObservingConditions::aGetHumidity(AsyncWebServerRequest *request) {
     if (OBSCON_HUMIDITY) {
-        float value = humidity_ra.getAverageLast(
-            _averaging > humidity_ra.getCount() ? humidity_ra.getCount() : _averaging);
+        float value = averaged.humidity;
         value = round(1. * value) / 1.;
         _alpacaServer->respond(request, value);
     } else {
@@ -248,8 +323,7 @@ void ObservingConditions::aGetHumidity(AsyncWebServerRequest *request) {
 
 void ObservingConditions::aGetDewPoint(AsyncWebServerRequest *request) {
     if (OBSCON_DEWPOINT) {
-        float value = dewpoint_ra.getAverageLast(
-            _averaging > dewpoint_ra.getCount() ? dewpoint_ra.getCount() : _averaging);
+        float value = averaged.dewpoint;
         value = round(10. * value) / 10.;
         _alpacaServer->respond(request, value);
     } else {
@@ -259,8 +333,7 @@ void ObservingConditions::aGetDewPoint(AsyncWebServerRequest *request) {
 
 void ObservingConditions::aGetPressure(AsyncWebServerRequest *request) {
     if (OBSCON_PRESSURE) {
-        float value = pressure_ra.getAverageLast(
-            _averaging > pressure_ra.getCount() ? pressure_ra.getCount() : _averaging);
+        float value = averaged.pressure;
         value = round(1. * value) / 1.;
         _alpacaServer->respond(request, value);
     } else {
@@ -270,8 +343,7 @@ void ObservingConditions::aGetPressure(AsyncWebServerRequest *request) {
 
 void ObservingConditions::aGetSkyTemperature(AsyncWebServerRequest *request) {
     if (OBSCON_SKYTEMP) {
-        float value = skytemp_ra.getAverageLast(
-            _averaging > skytemp_ra.getCount() ? skytemp_ra.getCount() : _averaging);
+        float value = averaged.skytemp;
         value = round(10. * value) / 10.;
         _alpacaServer->respond(request, value);
     } else {
@@ -281,8 +353,7 @@ void ObservingConditions::aGetSkyTemperature(AsyncWebServerRequest *request) {
 
 void ObservingConditions::aGetCloudCover(AsyncWebServerRequest *request) {
     if (OBSCON_CLOUDCOVER) {
-        float value = cloudcover_ra.getAverageLast(
-            _averaging > cloudcover_ra.getCount() ? cloudcover_ra.getCount() : _averaging);
+        float value = averaged.cloudcover;
         value = round(1. * value) / 1.;
         _alpacaServer->respond(request, value);
     } else {
@@ -292,8 +363,7 @@ void ObservingConditions::aGetCloudCover(AsyncWebServerRequest *request) {
 
 void ObservingConditions::aGetStarFwhm(AsyncWebServerRequest *request) {
     if (_noise_as_fwhm && OBSCON_FWHM) {
-        float value = noisedb_ra.getAverageLast(
-            _averaging > noisedb_ra.getCount() ? noisedb_ra.getCount() : _averaging);
+        float value = averaged.noisedb;
         value = round(10. * value) / 10.;
         _alpacaServer->respond(request, value);
     } else {
@@ -303,8 +373,7 @@ void ObservingConditions::aGetStarFwhm(AsyncWebServerRequest *request) {
 
 void ObservingConditions::aGetSkyBrightness(AsyncWebServerRequest *request) {
     if (OBSCON_SKYBRIGHTNESS) {
-        float value = skybrightness_ra.getAverageLast(
-            _averaging > skybrightness_ra.getCount() ? skybrightness_ra.getCount() : _averaging);
+        float value = averaged.skybrightness;
         value = round(10. * value) / 10.;
         _alpacaServer->respond(request, value);
     } else {
@@ -314,8 +383,7 @@ void ObservingConditions::aGetSkyBrightness(AsyncWebServerRequest *request) {
 
 void ObservingConditions::aGetSkyQuality(AsyncWebServerRequest *request) {
     if (OBSCON_SKYQUALITY) {
-        float value = skyquality_ra.getAverageLast(
-            _averaging > skyquality_ra.getCount() ? skyquality_ra.getCount() : _averaging);
+        float value = averaged.skyquality;
         value = round(10. * value) / 10.;
         _alpacaServer->respond(request, value);
     } else {
@@ -325,8 +393,7 @@ void ObservingConditions::aGetSkyQuality(AsyncWebServerRequest *request) {
 
 void ObservingConditions::aGetWindDirection(AsyncWebServerRequest *request) {
     if (OBSCON_WINDDIR) {
-        float value = winddir_ra.getAverageLast(
-            _averaging > winddir_ra.getCount() ? winddir_ra.getCount() : _averaging);
+        float value = averaged.winddir;
         value = round(1. * value) / 1.;
         _alpacaServer->respond(request, value);
     } else {
@@ -336,8 +403,8 @@ void ObservingConditions::aGetWindDirection(AsyncWebServerRequest *request) {
 
 void ObservingConditions::aGetWindGust(AsyncWebServerRequest *request) {
     if (OBSCON_WINDGUST) {
-        // Wind gust not averaged, ASCOM (https://ascom-standards.org/newdocs/observingconditions.html#ObservingConditions.WindGust)
-        float value = windgust;
+        // Peak gust of the period with the default max kernel, ASCOM (https://ascom-standards.org/newdocs/observingconditions.html#ObservingConditions.WindGust)
+        float value = averaged.windgust;
         value = round(10. * value) / 10.;
         _alpacaServer->respond(request, value);
     } else {
@@ -347,8 +414,7 @@ void ObservingConditions::aGetWindGust(AsyncWebServerRequest *request) {
 
 void ObservingConditions::aGetWindSpeed(AsyncWebServerRequest *request) {
     if (OBSCON_WINDSPEED) {
-        float value = windspeed_ra.getAverageLast(
-            _averaging > windspeed_ra.getCount() ? windspeed_ra.getCount() : _averaging);
+        float value = averaged.windspeed;
         value = round(10. * value) / 10.;
         _alpacaServer->respond(request, value);
     } else {
@@ -356,6 +422,21 @@ void ObservingConditions::aGetWindSpeed(AsyncWebServerRequest *request) {
     }
 }
 
+// Setup keys of the channel kernels, in ObsconChannel order
+static const char *kernelKeys[OBSCON_CHANNELS] = {
+    "F_Kernel_Rain_Rate",
+    "F_Kernel_Temperature",
+    "F_Kernel_Humidity",
+    "F_Kernel_Pressure",
+    "F_Kernel_Dewpoint",
+    "F_Kernel_Sky_Temp",
+    "F_Kernel_Turbulence",
+    "F_Kernel_Cloud_Cover",
+    "F_Kernel_Sky_Quality",
+    "F_Kernel_Sky_Brightness",
+    "F_Kernel_Wind_Speed",
+    "F_Kernel_Wind_Gust"};
+
 void ObservingConditions::aReadJson(JsonObject &root) {
     AlpacaObservingConditions::aReadJson(root);
     if (JsonObject obj_config = root[F("Configuration")]) {
@@ -364,14 +445,19 @@ void ObservingConditions::aReadJson(JsonObject &root) {
         if (_refresh < 3) {
             _refresh = 3;
         }
-        _averaging = _avgperiod / _refresh;
-        if (_averaging == 0) {
-            _averaging = 1;
-        }
+        _avgperiod = constrain(_avgperiod, 0, TS_MAX_PERIOD);
         if (obj_config[F("D_Turbulence_as_FWHM")].as<String>() == String("true"))
             _noise_as_fwhm = true;
         else
             _noise_as_fwhm = false;
+        for (int i = 0; i < OBSCON_CHANNELS; i++) {
+            if (obj_config[kernelKeys[i]].is<const char *>()) {
+                _kernel[i] = averageKernelFromString(obj_config[kernelKeys[i]].as<String>(), _kernel[i]);
+            }
+        }
+        if (obj_config[F("H_Percentiles_Reset")].is<const char *>()) {
+            _quantile_reset = quantileResetFromString(obj_config[F("H_Percentiles_Reset")].as<String>(), _quantile_reset);
+        }
     }
 }
 
@@ -381,8 +467,14 @@ void ObservingConditions::aWriteJson(JsonObject &root) {
     JsonObject obj_config = root[F("Configuration")].to<JsonObject>();
     obj_config[F("A_Average_Periodzc_sec")] = _avgperiod;
     obj_config[F("B_Refresh_Periodzc_sec")] = _refresh;
-    obj_config[F("C_Averagingzc_countszro")] = _averaging;
+    obj_config[F("C_Averaging_Bucketzc_secszro")] = temperature_ts.getResolution(_avgperiod);
     obj_config[F("D_Turbulence_as_FWHM")] = _noise_as_fwhm;
+    obj_config[F("E_Available_Kernelszro")] = "mean, ema, median, trimmed, max";
+    for (int i = 0; i < OBSCON_CHANNELS; i++) {
+        obj_config[kernelKeys[i]] = averageKernelAsString(_kernel[i]);
+    }
+    obj_config[F("G_Available_Resetszro")] = "off, hourly, nightly";
+    obj_config[F("H_Percentiles_Reset")] = quantileResetAsString(_quantile_reset);
     obj_config[F("Sensors_Descriptionzro")] = sensordescription;
 
     // instant
@@ -394,6 +486,7 @@ void ObservingConditions::aWriteJson(JsonObject &root) {
     obj_instant_state[F("Pressure,_hPazro")] = OBSCON_PRESSURE ? String(pressure, 0) : "n/a";
     obj_instant_state[F("Sky_Temp,_°Czro")] = OBSCON_SKYTEMP ? String(skytemp, 1) : "n/a";
     obj_instant_state[F("Cloud_Cover,_zpzro")] = OBSCON_CLOUDCOVER ? String(cloudcover, 0) : "n/a";
+    obj_instant_state[F("Cloud_Conditionzro")] = OBSCON_CLOUDCOVER ? CloudClassifier::classAsString(cloudclass) : "n/a";
     // not exactly seeing (fwhm)
     obj_instant_state[F("Turbulence,_dBzro")] = OBSCON_FWHM ? String(noisedb, 1) : "n/a";
     obj_instant_state[F("Sky_Quality,_m/saszro")] = OBSCON_SKYQUALITY ? String(skyquality, 1) : "n/a";
@@ -405,20 +498,35 @@ void ObservingConditions::aWriteJson(JsonObject &root) {
 
     // averaged
     JsonObject obj_averaged_state = root[F("Averaged State (ASCOM)")].to<JsonObject>();
-    obj_averaged_state[F("Rain_Rate,_mm/hzro")] = OBSCON_RAINRATE ? String(rainrate_ra.getAverageLast(_averaging > rainrate_ra.getCount() ? rainrate_ra.getCount() : _averaging), 2) : "n/a";
-    obj_averaged_state[F("Temperature,_°Czro")] = OBSCON_TEMPERATURE ? String(temperature_ra.getAverageLast(_averaging > temperature_ra.getCount() ? temperature_ra.getCount() : _averaging), 1) : "n/a";
-    obj_averaged_state[F("Humidity,_zpzro")] = OBSCON_HUMIDITY ? String(humidity_ra.getAverageLast(_averaging > humidity_ra.getCount() ? humidity_ra.getCount() : _averaging), 0) : "n/a";
-    obj_averaged_state[F("Dewpoint,_°Czro")] = OBSCON_DEWPOINT ? String(dewpoint_ra.getAverageLast(_averaging > dewpoint_ra.getCount() ? dewpoint_ra.getCount() : _averaging), 1) : "n/a";
-    obj_averaged_state[F("Pressure,_hPazro")] = OBSCON_PRESSURE ? String(pressure_ra.getAverageLast(_averaging > pressure_ra.getCount() ? pressure_ra.getCount() : _averaging), 0) : "n/a";
-    obj_averaged_state[F("Sky_Temp,_°Czro")] = OBSCON_SKYTEMP ? String(skytemp_ra.getAverageLast(_averaging > skytemp_ra.getCount() ? skytemp_ra.getCount() : _averaging), 1) : "n/a";
-    obj_averaged_state[F("Cloud_Cover,_zpzro")] = OBSCON_CLOUDCOVER ? String(cloudcover_ra.getAverageLast(_averaging > cloudcover_ra.getCount() ? cloudcover_ra.getCount() : _averaging), 0) : "n/a";
+    obj_averaged_state[F("Rain_Rate,_mm/hzro")] = OBSCON_RAINRATE ? String(averaged.rainrate, 2) : "n/a";
+    obj_averaged_state[F("Temperature,_°Czro")] = OBSCON_TEMPERATURE ? String(averaged.temperature, 1) : "n/a";
+    obj_averaged_state[F("Humidity,_zpzro")] = OBSCON_HUMIDITY ? String(averaged.humidity, 0) : "n/a";
+    obj_averaged_state[F("Dewpoint,_°Czro")] = OBSCON_DEWPOINT ? String(averaged.dewpoint, 1) : "n/a";
+    obj_averaged_state[F("Pressure,_hPazro")] = OBSCON_PRESSURE ? String(averaged.pressure, 0) : "n/a";
+    obj_averaged_state[F("Sky_Temp,_°Czro")] = OBSCON_SKYTEMP ? String(averaged.skytemp, 1) : "n/a";
+    obj_averaged_state[F("Cloud_Cover,_zpzro")] = OBSCON_CLOUDCOVER ? String(averaged.cloudcover, 0) : "n/a";
     // not exactly seeing (fwhm)
-    obj_averaged_state[F("Turbulence,_dBzro")] = OBSCON_FWHM ? String(noisedb_ra.getAverageLast(_averaging > noisedb_ra.getCount() ? noisedb_ra.getCount() : _averaging), 1) : "n/a";
-    obj_averaged_state[F("Sky_Quality,_m/saszro")] = OBSCON_SKYQUALITY ? String(skyquality_ra.getAverageLast(_averaging > skyquality_ra.getCount() ? skyquality_ra.getCount() : _averaging), 1) : "n/a";
-    obj_averaged_state[F("Sky_Brightness,_luxzro")] = OBSCON_SKYBRIGHTNESS ? smart_round(skybrightness_ra.getAverageLast(_averaging > skybrightness_ra.getCount() ? skybrightness_ra.getCount() : _averaging)) : "n/a";
-    obj_averaged_state[F("Wind_Direction,_°zro")] = OBSCON_WINDDIR ? String(winddir_ra.getAverageLast(_averaging > winddir_ra.getCount() ? winddir_ra.getCount() : _averaging), 1) : "n/a";
-    obj_averaged_state[F("Wind_Speed,_m/szro")] = OBSCON_WINDSPEED ? String(windspeed_ra.getAverageLast(_averaging > windspeed_ra.getCount() ? windspeed_ra.getCount() : _averaging), 1) : "n/a";
-    // Wind gust not averaged, ASCOM (https://ascom-standards.org/newdocs/observingconditions.html#ObservingConditions.WindGust)
-    obj_averaged_state[F("Wind_Gust,_m/szro")] = OBSCON_WINDGUST ? String(windgust, 1) : "n/a";
+    obj_averaged_state[F("Turbulence,_dBzro")] = OBSCON_FWHM ? String(averaged.noisedb, 1) : "n/a";
+    obj_averaged_state[F("Sky_Quality,_m/saszro")] = OBSCON_SKYQUALITY ? String(averaged.skyquality, 1) : "n/a";
+    obj_averaged_state[F("Sky_Brightness,_luxzro")] = OBSCON_SKYBRIGHTNESS ? smart_round(averaged.skybrightness) : "n/a";
+    obj_averaged_state[F("Wind_Direction,_°zro")] = OBSCON_WINDDIR ? String(averaged.winddir, 0) : "n/a";
+    obj_averaged_state[F("Wind_Speed,_m/szro")] = OBSCON_WINDSPEED ? String(averaged.windspeed, 1) : "n/a";
+    obj_averaged_state[F("Wind_Gust,_m/szro")] = OBSCON_WINDGUST ? String(averaged.windgust, 1) : "n/a";
     obj_averaged_state[F("Updated,_secs/agozro")] = String(((float)millis() - (float)timelastupdate) / 1000., 1);
+
+    // trends
+    JsonObject obj_trend_state = root[F("Trends (Least Squares)")].to<JsonObject>();
+    obj_trend_state[F("Pressure_Tendency,_hPa/1hzro")] = trendAsString(OBSCON_PRESSURE, pressure_tendency_1h, 2);
+    obj_trend_state[F("Pressure_Tendency,_hPa/3hzro")] = trendAsString(OBSCON_PRESSURE, pressure_tendency_3h, 2);
+    obj_trend_state[F("Temperature,_°C/hzro")] = trendAsString(OBSCON_TEMPERATURE, temperature_trend, 2);
+    obj_trend_state[F("Humidity,_zp/hzro")] = trendAsString(OBSCON_HUMIDITY, humidity_trend, 1);
+    obj_trend_state[F("Sky_Temp,_°C/hzro")] = trendAsString(OBSCON_SKYTEMP, skytemp_trend, 2);
+
+    // percentiles
+    JsonObject obj_quantile_state = root[F("Percentiles (p10/p50/p90)")].to<JsonObject>();
+    obj_quantile_state[F("Wind_Speed,_m/szro")] = OBSCON_WINDSPEED ? windspeed_q.asString(1) : "n/a";
+    obj_quantile_state[F("Sky_Temp,_°Czro")] = OBSCON_SKYTEMP ? skytemp_q.asString(1) : "n/a";
+    obj_quantile_state[F("Sky_Quality,_m/saszro")] = OBSCON_SKYQUALITY ? skyquality_q.asString(2) : "n/a";
+    obj_quantile_state[F("Samples,_countzro")] = max(windspeed_q.getCount(), max(skytemp_q.getCount(), skyquality_q.getCount()));
+    obj_quantile_state[F("Resetzro")] = quantileResetAsString(_quantile_reset);
 }
\ No newline at end of file
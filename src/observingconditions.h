@@ -2,11 +2,38 @@
 
 #include <AlpacaObservingConditions.h>
 #include <Arduino.h>
-#include <RunningAverage.h>
 #include "config.h"
 #include "meteo.h"
+#include "quantile.h"
+#include "timeseries.h"
 #include "version.h"
 
+// Averaged channels, wind direction is always a vector mean
+class ObsconChannel {
+  public:
+    static const int RainRate = 0;
+    static const int Temperature = 1;
+    static const int Humidity = 2;
+    static const int Pressure = 3;
+    static const int DewPoint = 4;
+    static const int SkyTemperature = 5;
+    static const int Turbulence = 6;
+    static const int CloudCover = 7;
+    static const int SkyQuality = 8;
+    static const int SkyBrightness = 9;
+    static const int WindSpeed = 10;
+    static const int WindGust = 11;
+};
+#define OBSCON_CHANNELS 12
+// Time series kept, the averaged channels and the wind direction vector
+#define OBSCON_SERIES 14
+
+// Averaged history of every series for a warm start
+struct ObsconCheckpoint {
+    TimeSeriesCheckpoint series[OBSCON_SERIES];
+    bool turbulence_highrate;
+};
+
 class ObservingConditions : public AlpacaObservingConditions {
   private:
     static uint8_t _n_observingconditionss;
@@ -36,29 +63,55 @@ class ObservingConditions : public AlpacaObservingConditions {
         skytemp,
         noisedb,
         cloudcover,
+        cloudclass = 0,
         skyquality = 0,
         skybrightness = 0,
         windgust = 0,
         windspeed = 0,
         winddir = 0;
-    RunningAverage temperature_ra = RunningAverage(1200),
-                   humidity_ra = RunningAverage(1200),
-                   pressure_ra = RunningAverage(1200),
-                   rainrate_ra = RunningAverage(1200),
-                   dewpoint_ra = RunningAverage(1200),
-                   skytemp_ra = RunningAverage(1200),
-                   noisedb_ra = RunningAverage(1200),
-                   cloudcover_ra = RunningAverage(1200),
-                   skyquality_ra = RunningAverage(1200),
-                   skybrightness_ra = RunningAverage(1200),
-                   windgust_ra = RunningAverage(1200),
-                   windspeed_ra = RunningAverage(1200),
-                   winddir_ra = RunningAverage(1200);
+    // Least squares trends of Meteo, per hour, NaN until covered
+    float pressure_tendency_1h = NAN,
+          pressure_tendency_3h = NAN,
+          temperature_trend = NAN,
+          humidity_trend = NAN,
+          skytemp_trend = NAN;
+    String trendAsString(bool enabled, float value, unsigned int decimals);
+    // Time bucketed history, averages follow AveragePeriod regardless of the update rate
+    TimeSeries temperature_ts,
+               humidity_ts,
+               pressure_ts,
+               rainrate_ts,
+               dewpoint_ts,
+               skytemp_ts,
+               noisedb_ts,
+               cloudcover_ts,
+               skyquality_ts,
+               skybrightness_ts,
+               windgust_ts,
+               windspeed_ts,
+               winddir_x_ts,
+               winddir_y_ts;
+    TimeSeries *_series[OBSCON_SERIES] = {&rainrate_ts, &temperature_ts, &humidity_ts, &pressure_ts, &dewpoint_ts, &skytemp_ts, &noisedb_ts,
+                                          &cloudcover_ts, &skyquality_ts, &skybrightness_ts, &windspeed_ts, &windgust_ts, &winddir_x_ts, &winddir_y_ts};
+    // Averaging kernel per ObsconChannel, the peak gust of the period by default
+    uint8_t _kernel[OBSCON_CHANNELS] = {AverageKernel::Mean, AverageKernel::Mean, AverageKernel::Mean, AverageKernel::Mean,
+                                        AverageKernel::Mean, AverageKernel::Mean, AverageKernel::Mean, AverageKernel::Mean,
+                                        AverageKernel::Mean, AverageKernel::Mean, AverageKernel::Mean, AverageKernel::Max};
+    float average(TimeSeries &ts, int channel);
+    // Percentile reset boundary and the period being accumulated, a changed boundary resets in update()
+    volatile uint8_t _quantile_reset = QuantileReset::Nightly;
+    uint32_t _quantile_period = 0;
+    // Reset asked from another task, applied by update() between two samples
+    volatile bool _quantile_reset_requested = false;
+    void resetQuantiles();
+    // Turbulence source the series holds, the FFT index or the noise dB
+    bool _turbulence_highrate = false;
+    // Wind direction is averaged as speed-weighted unit vectors
+    float averageWindDirection();
     unsigned long timelastupdate;
     const char *sensordescription = "Xiao Seeed ESP32S3/BMP280/AHT20/MLX90614";
     int _avgperiod = 30;
     int _refresh = 3;
-    int _averaging = 1;
     bool _noise_as_fwhm = true;
 
     // immediate update
@@ -70,12 +123,44 @@ class ObservingConditions : public AlpacaObservingConditions {
     // Set current logger
     void setLogger(const int, std::function<void(String, const int)> logLineCallback = nullptr, std::function<void(String, const int)> logLinePartCallback = nullptr, std::function<String()> logTimeCallback = nullptr);
 
+    // Averages over AveragePeriod, refreshed at update time and served as is by the alpaca getters
+    struct {
+        float rainrate,
+            temperature,
+            humidity,
+            pressure,
+            dewpoint,
+            skytemp,
+            noisedb,
+            cloudcover,
+            skyquality,
+            skybrightness,
+            winddir,
+            windspeed,
+            windgust;
+    } averaged = {0};
+
+    // Streaming percentiles since the last reset boundary
+    QuantileSet windspeed_q,
+                skytemp_q,
+                skyquality_q;
+    // Percentiles restart at the next update
+    void requestQuantilesReset() { _quantile_reset_requested = true; }
+    String quantilesAsString();
+
     bool begin();
     void update(Meteo*);
+    // Recalculate the averages, called by update() so an AveragePeriod change shows at the next update
+    void updateAverages();
+    void checkpoint(ObsconCheckpoint *cp);
+    // Averages of a checkpoint taken age seconds ago
+    void restore(const ObsconCheckpoint *cp, uint32_t age);
 
     // getters
     int getRefresh() { return _refresh; }
     int getAveragePeriod() { return _avgperiod; }
+    uint8_t getKernel(int channel) { return _kernel[channel]; }
+    uint8_t getQuantileReset() { return _quantile_reset; }
 
     // alpaca getters
     void aGetDescription(AsyncWebServerRequest *request) override;
@@ -101,10 +186,17 @@ class ObservingConditions : public AlpacaObservingConditions {
 
     // alpaca setters
     void aPutAveragePeriod(AsyncWebServerRequest *request) {
-        // ASCOM required hours
-        float value;
+        // ASCOM required hours, a missing value is rejected too
+        float value = -1;
         _alpacaServer->getParam(request, "averageperiod", value);
-        _avgperiod = (int)round(3600. * value);
+        int period = (int)round(3600. * value);
+        if (value < 0 || period > TS_MAX_PERIOD) {
+            String message = "Average period must be 0 to " + String(TS_MAX_PERIOD / 3600., 2) + " hours";
+            _alpacaServer->respond(request, nullptr, AlpacaInvalidValue, message.c_str());
+            return;
+        }
+        // Averages are refreshed by the next update(), not from the web server task
+        _avgperiod = period;
         _alpacaServer->respond(request, nullptr);
     }
     void aPutRefresh(AsyncWebServerRequest *request) {
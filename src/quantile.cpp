@@ -0,0 +1,153 @@
+#include "quantile.h"
+#include <time.h>
+
+void P2Quantile::clear() {
+    count = 0;
+    for (int i = 0; i < 5; i++) {
+        q[i] = 0;
+        n[i] = i;
+    }
+    np[0] = 0;
+    np[1] = 2 * p;
+    np[2] = 4 * p;
+    np[3] = 2 + 2 * p;
+    np[4] = 4;
+}
+
+float P2Quantile::parabolic(int i, int d) {
+    return q[i] + (float)d / (n[i + 1] - n[i - 1]) *
+                      ((n[i] - n[i - 1] + d) * (q[i + 1] - q[i]) / (n[i + 1] - n[i]) +
+                       (n[i + 1] - n[i] - d) * (q[i] - q[i - 1]) / (n[i] - n[i - 1]));
+}
+
+float P2Quantile::linear(int i, int d) {
+    return q[i] + d * (q[i + d] - q[i]) / (n[i + d] - n[i]);
+}
+
+void P2Quantile::add(float x) {
+    if (std::isnan(x)) {
+        return;
+    }
+    // The first five samples are kept sorted as the initial markers
+    if (count < 5) {
+        int i = count++;
+        while (i > 0 && q[i - 1] > x) {
+            q[i] = q[i - 1];
+            i--;
+        }
+        q[i] = x;
+        return;
+    }
+    count++;
+    // Cell of the sample, extreme markers follow the range
+    int k;
+    if (x < q[0]) {
+        q[0] = x;
+        k = 0;
+    } else if (x >= q[4]) {
+        q[4] = x;
+        k = 3;
+    } else {
+        k = 0;
+        while (x >= q[k + 1]) {
+            k++;
+        }
+    }
+    for (int i = k + 1; i < 5; i++) {
+        n[i]++;
+    }
+    const float dn[5] = {0, p / 2, p, (1 + p) / 2, 1};
+    for (int i = 0; i < 5; i++) {
+        np[i] += dn[i];
+    }
+    // Move the middle markers towards their desired positions by one step at most
+    for (int i = 1; i < 4; i++) {
+        float d = np[i] - n[i];
+        if ((d >= 1 && n[i + 1] - n[i] > 1) || (d <= -1 && n[i - 1] - n[i] < -1)) {
+            int step = d > 0 ? 1 : -1;
+            float h = parabolic(i, step);
+            q[i] = q[i - 1] < h && h < q[i + 1] ? h : linear(i, step);
+            n[i] += step;
+        }
+    }
+}
+
+float P2Quantile::get() {
+    if (count == 0) {
+        return 0;
+    }
+    if (count < 5) {
+        return q[(int)roundf(p * (count - 1))];
+    }
+    return q[2];
+}
+
+QuantileSet::QuantileSet() {
+    const float probabilities[QUANTILE_COUNT] = QUANTILE_PROBABILITIES;
+    for (int i = 0; i < QUANTILE_COUNT; i++) {
+        estimators[i] = P2Quantile(probabilities[i]);
+    }
+}
+
+void QuantileSet::clear() {
+    for (int i = 0; i < QUANTILE_COUNT; i++) {
+        estimators[i].clear();
+    }
+}
+
+void QuantileSet::add(float x) {
+    for (int i = 0; i < QUANTILE_COUNT; i++) {
+        estimators[i].add(x);
+    }
+}
+
+String QuantileSet::asString(unsigned int decimals) {
+    if (getCount() == 0) {
+        return "n/a";
+    }
+    String s = "";
+    for (int i = 0; i < QUANTILE_COUNT; i++) {
+        s += (i ? "/" : "") + String(get(i), decimals);
+    }
+    return s;
+}
+
+uint32_t quantileResetPeriod(uint8_t mode) {
+    time_t now = time(nullptr);
+    // Uptime based boundaries until NTP sets the clock
+    bool synced = now > NTP_TIME_VALID;
+    switch (mode) {
+    case QuantileReset::Hourly:
+        return synced ? now / 3600 : millis() / 3600000UL;
+    case QuantileReset::Nightly:
+        if (synced) {
+            struct tm timeinfo;
+            time_t shifted = now - QUANTILE_NIGHT_HOUR * 3600;
+            localtime_r(&shifted, &timeinfo);
+            return timeinfo.tm_year * 366 + timeinfo.tm_yday;
+        }
+        return millis() / 86400000UL;
+    }
+    return 0;
+}
+
+String quantileResetAsString(uint8_t mode) {
+    switch (mode) {
+    case QuantileReset::Hourly:
+        return "hourly";
+    case QuantileReset::Nightly:
+        return "nightly";
+    }
+    return "off";
+}
+
+uint8_t quantileResetFromString(String name, uint8_t fallback) {
+    name.trim();
+    name.toLowerCase();
+    for (uint8_t mode = QuantileReset::Off; mode <= QuantileReset::Nightly; mode++) {
+        if (name == quantileResetAsString(mode)) {
+            return mode;
+        }
+    }
+    return fallback;
+}
@@ -0,0 +1,63 @@
+#pragma once
+
+#include "config.h"
+#include <Arduino.h>
+
+// Percentiles tracked per channel
+#define QUANTILE_COUNT 3
+#define QUANTILE_PROBABILITIES {0.1, 0.5, 0.9}
+// Local hour the night boundary falls on
+#define QUANTILE_NIGHT_HOUR 12
+
+// Quantile estimator boundaries
+class QuantileReset {
+  public:
+    static const uint8_t Off = 0;
+    static const uint8_t Hourly = 1;
+    // At QUANTILE_NIGHT_HOUR local time, a night is never split
+    static const uint8_t Nightly = 2;
+};
+
+// P² streaming quantile estimator (Jain & Chlamtac), five markers, O(1) per sample
+class P2Quantile {
+  private:
+    float p;
+    // Marker heights, positions and desired positions
+    float q[5];
+    int32_t n[5];
+    float np[5];
+    uint32_t count = 0;
+    float parabolic(int i, int d);
+    float linear(int i, int d);
+
+  public:
+    P2Quantile(float probability = 0.5) : p(probability) { clear(); }
+    void clear();
+    void add(float x);
+    // Exact for less than five samples
+    float get();
+    uint32_t getCount() { return count; }
+    float getProbability() { return p; }
+};
+
+// p10, p50 and p90 of a channel since the last reset boundary
+class QuantileSet {
+  private:
+    P2Quantile estimators[QUANTILE_COUNT];
+
+  public:
+    QuantileSet();
+    void clear();
+    void add(float x);
+    float get(int i) { return estimators[i].get(); }
+    float getProbability(int i) { return estimators[i].getProbability(); }
+    uint32_t getCount() { return estimators[0].getCount(); }
+    // "p10/p50/p90" with the given decimals, n/a before the first sample
+    String asString(unsigned int decimals);
+};
+
+// Number of the current reset period, a change means a boundary was crossed
+uint32_t quantileResetPeriod(uint8_t mode);
+String quantileResetAsString(uint8_t mode);
+// Reset mode by name, fallback for an unknown one
+uint8_t quantileResetFromString(String name, uint8_t fallback);
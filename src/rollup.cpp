@@ -0,0 +1,181 @@
+#include "rollup.h"
+
+Rollups rollups;
+
+static const uint32_t rollupSeconds[ROLLUP_TIERS] = ROLLUP_TIER_SECONDS;
+static const uint16_t rollupBuckets[ROLLUP_TIERS] = ROLLUP_TIER_BUCKETS;
+
+void RollupTier::begin(RollupBucket *storage, uint32_t bucketSeconds, uint16_t bucketCount) {
+    buckets = storage;
+    seconds = bucketSeconds;
+    size = bucketCount;
+    clear();
+}
+
+void RollupTier::clear() {
+    newest = 0;
+    for (uint16_t i = 0; i < size; i++) {
+        buckets[i].start = 0;
+    }
+}
+
+void RollupTier::add(const TsLogRecord &record) {
+    uint32_t n = record.time / seconds;
+    // Older than the ring, e.g. a replay after live records
+    if (newest > 0 && n + size <= newest) {
+        return;
+    }
+    RollupBucket &b = buckets[n % size];
+    if (b.start != n * seconds) {
+        b.start = n * seconds;
+        for (int i = 0; i < TSLOG_CHANNELS; i++) {
+            b.min[i] = INT16_MAX;
+            b.max[i] = INT16_MIN;
+            b.sum[i] = 0;
+            b.count[i] = 0;
+        }
+    }
+    for (int i = 0; i < TSLOG_CHANNELS; i++) {
+        int16_t v = record.values[i];
+        if (v != TSLOG_INVALID) {
+            b.min[i] = min(b.min[i], v);
+            b.max[i] = max(b.max[i], v);
+            b.sum[i] += v;
+            b.count[i]++;
+        }
+    }
+    newest = max(newest, n);
+}
+
+RollupBucket *RollupTier::get(uint32_t n) {
+    RollupBucket &b = buckets[n % size];
+    return covers(n) && b.start == n * seconds ? &b : nullptr;
+}
+
+uint32_t Rollups::getMemoryNeeded() {
+    uint32_t bytes = 0;
+    for (int t = 0; t < ROLLUP_TIERS; t++) {
+        bytes += rollupBuckets[t] * sizeof(RollupBucket);
+    }
+    return bytes;
+}
+
+bool Rollups::begin(uint8_t *storage) {
+    if (!mutex) {
+        mutex = xSemaphoreCreateMutex();
+    }
+    ready = storage != nullptr;
+    if (!ready) {
+        return false;
+    }
+    RollupBucket *buckets = (RollupBucket *)storage;
+    for (int t = 0; t < ROLLUP_TIERS; t++) {
+        tiers[t].begin(buckets, rollupSeconds[t], rollupBuckets[t]);
+        buckets += rollupBuckets[t];
+    }
+    return true;
+}
+
+void Rollups::clear() {
+    if (!ready) {
+        return;
+    }
+    xSemaphoreTake(mutex, portMAX_DELAY);
+    for (int t = 0; t < ROLLUP_TIERS; t++) {
+        tiers[t].clear();
+    }
+    xSemaphoreGive(mutex);
+}
+
+void Rollups::add(const TsLogRecord &record) {
+    if (!ready) {
+        return;
+    }
+    xSemaphoreTake(mutex, portMAX_DELAY);
+    for (int t = 0; t < ROLLUP_TIERS; t++) {
+        tiers[t].add(record);
+    }
+    xSemaphoreGive(mutex);
+}
+
+RollupResult Rollups::summarize(int channel, uint32_t from, uint32_t to) {
+    RollupResult result = {NAN, NAN, NAN, 0, 0};
+    if (!ready || channel < 0 || channel >= TSLOG_CHANNELS) {
+        return result;
+    }
+    int16_t lo = INT16_MAX, hi = INT16_MIN;
+    int64_t sum = 0;
+    // Minute records, a partial minute at from belongs to the previous range
+    uint32_t t = (from + 59) / 60 * 60;
+    xSemaphoreTake(mutex, portMAX_DELAY);
+    while (t < to) {
+        // Coarsest aligned bucket inside the range, otherwise the finest one still held
+        RollupTier *tier = nullptr;
+        for (int i = ROLLUP_TIERS - 1; i >= 0; i--) {
+            uint32_t s = tiers[i].getSeconds();
+            if (t % s == 0 && t + s <= to && tiers[i].covers(t / s)) {
+                tier = &tiers[i];
+                break;
+            }
+        }
+        for (int i = 0; tier == nullptr && i < ROLLUP_TIERS; i++) {
+            if (tiers[i].covers(t / tiers[i].getSeconds())) {
+                tier = &tiers[i];
+            }
+        }
+        if (tier == nullptr) {
+            // Not held by any tier, skip to the oldest day bucket
+            uint32_t oldest = tiers[ROLLUP_TIERS - 1].getOldest();
+            if (oldest <= t) {
+                break;
+            }
+            t = oldest;
+            continue;
+        }
+        uint32_t n = t / tier->getSeconds();
+        if (n * tier->getSeconds() < t) {
+            // Started before the range, counted by the range holding its start
+            t = (n + 1) * tier->getSeconds();
+            continue;
+        }
+        RollupBucket *b = tier->get(n);
+        if (b && b->count[channel] > 0) {
+            lo = min(lo, b->min[channel]);
+            hi = max(hi, b->max[channel]);
+            sum += b->sum[channel];
+            result.count += b->count[channel];
+        }
+        result.buckets++;
+        t = (n + 1) * tier->getSeconds();
+    }
+    xSemaphoreGive(mutex);
+    if (result.count > 0) {
+        result.min = tslogDequantize(lo, channel);
+        result.max = tslogDequantize(hi, channel);
+        result.mean = tslogMean(sum, result.count, channel);
+    }
+    return result;
+}
+
+uint32_t Rollups::query(int channel, uint32_t from, uint32_t to, uint32_t resolution, std::function<void(uint32_t, const RollupResult &)> callback) {
+    uint32_t answered = 0;
+    resolution = max((resolution + 59) / 60 * 60, (uint32_t)60);
+    for (uint32_t t = from / resolution * resolution; t < to; t += resolution) {
+        RollupResult r = summarize(channel, max(t, from), min(t + resolution, to));
+        if (r.count > 0) {
+            callback(t, r);
+            answered++;
+        }
+    }
+    return answered;
+}
+
+void initRollups() {
+    uint8_t *storage = nullptr;
+    if (psramFound()) {
+        storage = (uint8_t *)ps_malloc(Rollups::getMemoryNeeded());
+    }
+    if (rollups.begin(storage)) {
+        tslog.replay([](const TsLogRecord &r) { rollups.add(r); });
+    }
+}
@@ -0,0 +1,89 @@
+#pragma once
+
+#include "tslog.h"
+#include <Arduino.h>
+#include <functional>
+
+// Rollup tiers, bucket length and buckets kept
+#define ROLLUP_TIERS 4
+#define ROLLUP_TIER_SECONDS {60, 600, 3600, 86400}
+// 24 hours, 7 days, 31 days and a year
+#define ROLLUP_TIER_BUCKETS {1440, 1008, 744, 366}
+
+// Aggregate of the flash log channels over a bucket, values quantized like TsLogRecord
+struct RollupBucket {
+    // Bucket start, a stale slot of the ring has another one
+    uint32_t start;
+    int16_t min[TSLOG_CHANNELS];
+    int16_t max[TSLOG_CHANNELS];
+    int32_t sum[TSLOG_CHANNELS];
+    uint16_t count[TSLOG_CHANNELS];
+};
+
+// Aggregate of a channel over a queried range
+struct RollupResult {
+    float min;
+    float max;
+    float mean;
+    // Minutes with a value
+    uint32_t count;
+    // Tier buckets merged to answer
+    uint32_t buckets;
+};
+
+// Ring of fixed length buckets aligned to the epoch
+class RollupTier {
+  private:
+    RollupBucket *buckets = nullptr;
+    uint32_t seconds = 0;
+    uint16_t size = 0;
+    // Latest bucket number (time / seconds)
+    uint32_t newest = 0;
+
+  public:
+    void begin(RollupBucket *storage, uint32_t bucketSeconds, uint16_t bucketCount);
+    void clear();
+    void add(const TsLogRecord &record);
+    uint32_t getSeconds() { return seconds; }
+    // Bucket n is still held by the ring
+    bool covers(uint32_t n) { return newest > 0 && n <= newest && n + size > newest; }
+    // Bucket n, nullptr if empty
+    RollupBucket *get(uint32_t n);
+    // Oldest held time
+    uint32_t getOldest() { return newest >= size ? (newest - size + 1) * seconds : 0; }
+    uint32_t getMemory() { return size * sizeof(RollupBucket); }
+};
+
+// 1 min, 10 min, 1 h and 1 day rollups of the flash log channels, maintained per minute record
+class Rollups {
+  private:
+    RollupTier tiers[ROLLUP_TIERS];
+    bool ready = false;
+    SemaphoreHandle_t mutex = nullptr;
+
+  public:
+    ~Rollups() {
+        if (mutex) {
+            vSemaphoreDelete(mutex);
+        }
+    }
+    // Storage of getMemoryNeeded() bytes
+    bool begin(uint8_t *storage);
+    bool isReady() { return ready; }
+    void clear();
+    void add(const TsLogRecord &record);
+    // Channel aggregate of [from, to), coarsest tier buckets that fit the range, finer ones at the edges.
+    // A bucket counts in the range holding its start, so where only a coarse tier is left the last one
+    // reaches past to, and adjacent ranges never count a bucket twice
+    RollupResult summarize(int channel, uint32_t from, uint32_t to);
+    // Aggregates of consecutive resolution long buckets of [from, to) aligned to whole resolutions,
+    // resolution rounded up to whole minutes, constant cost per answered bucket
+    uint32_t query(int channel, uint32_t from, uint32_t to, uint32_t resolution, std::function<void(uint32_t, const RollupResult &)> callback);
+    RollupTier *getTier(int i) { return &tiers[i]; }
+    static uint32_t getMemoryNeeded();
+};
+
+extern Rollups rollups;
+
+// Allocate the tiers in PSRAM and replay the flash log into them
+void initRollups();
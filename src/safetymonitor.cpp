@@ -262,6 +262,51 @@ void SafetyMonitor::update(Meteo* meteo) {
     }
 };
 
+void SafetyMonitor::checkpoint(SafemonCheckpoint *cp) {
+    cp->rain_init = rain_init;
+    cp->safeunsafe_init = safeunsafe_init;
+    cp->rain_safe = rain_safe;
+    cp->temp_safe = temp_safe;
+    cp->humi_safe = humi_safe;
+    cp->dewdelta_safe = dewdelta_safe;
+    cp->skytemp_safe = skytemp_safe;
+    cp->wind_safe = wind_safe;
+    cp->is_safe = is_safe;
+    cp->rainrate_state = rainrate_state;
+    cp->safeunsafe_state = safeunsafe_state;
+    cp->rainrate = rainrate;
+    cp->rainrate_prev = rainrate_prev;
+    cp->safeunsafe_prev = safeunsafe_prev;
+    cp->rainrate_elapsed = rainrate_occur ? max(millis() - rainrate_occur, 1UL) : 0;
+    cp->safeunsafe_elapsed = safeunsafe_occur ? max(millis() - safeunsafe_occur, 1UL) : 0;
+}
+
+void SafetyMonitor::restore(const SafemonCheckpoint *cp, uint32_t age) {
+    rain_init = cp->rain_init;
+    safeunsafe_init = cp->safeunsafe_init;
+    rain_safe = cp->rain_safe;
+    temp_safe = cp->temp_safe;
+    humi_safe = cp->humi_safe;
+    dewdelta_safe = cp->dewdelta_safe;
+    skytemp_safe = cp->skytemp_safe;
+    wind_safe = cp->wind_safe;
+    is_safe = cp->is_safe;
+    rainrate_state = (RainRateState)cp->rainrate_state;
+    safeunsafe_state = (SafeUnsafeStatus)cp->safeunsafe_state;
+    rainrate = cp->rainrate;
+    rainrate_prev = cp->rainrate_prev;
+    safeunsafe_prev = cp->safeunsafe_prev;
+    // Start times before boot wrap around, millis() - occur is still the elapsed time, 0 means no countdown
+    rainrate_occur = 0;
+    if (cp->rainrate_elapsed) {
+        rainrate_occur = max(millis() - (cp->rainrate_elapsed + age * 1000UL), 1UL);
+    }
+    safeunsafe_occur = 0;
+    if (cp->safeunsafe_elapsed) {
+        safeunsafe_occur = max(millis() - (cp->safeunsafe_elapsed + age * 1000UL), 1UL);
+    }
+}
+
 void SafetyMonitor::aGetDescription(AsyncWebServerRequest *request) {
     String description = "DreamSky Safety Conditions Monitor";
     _alpacaServer->respond(request, description.c_str());
@@ -20,6 +20,27 @@ enum SafeUnsafeStatus {
     AWAIT_UNSAFE
 };
 
+// Hysteresis flags and running countdowns for a warm start
+struct SafemonCheckpoint {
+    bool rain_init;
+    bool safeunsafe_init;
+    bool rain_safe;
+    bool temp_safe;
+    bool humi_safe;
+    bool dewdelta_safe;
+    bool skytemp_safe;
+    bool wind_safe;
+    bool is_safe;
+    uint8_t rainrate_state;
+    uint8_t safeunsafe_state;
+    float rainrate;
+    float rainrate_prev;
+    float safeunsafe_prev;
+    // Time since the countdown started, ms, 0 without a countdown
+    uint32_t rainrate_elapsed;
+    uint32_t safeunsafe_elapsed;
+};
+
 class SafetyMonitor : public AlpacaSafetyMonitor {
   private:
     static uint8_t _n_safetymonitors;
@@ -102,6 +123,9 @@ class SafetyMonitor : public AlpacaSafetyMonitor {
 
     bool begin();
     void update(Meteo*);
+    void checkpoint(SafemonCheckpoint *cp);
+    // State of a checkpoint taken age seconds ago, countdowns go on from where they were
+    void restore(const SafemonCheckpoint *cp, uint32_t age);
 
     // alpaca getters
     void aGetDescription(AsyncWebServerRequest *request) override;
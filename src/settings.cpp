@@ -0,0 +1,51 @@
+#include "settings.h"
+#include "meteosht.h"
+#include "statistics.h"
+#include <Arduino.h>
+#include <Preferences.h>
+
+Preferences sensorSettingsPrefs;
+
+float sensorSettings[SENSOR_SETTINGS_SIZE];
+
+// Replace out of range values (e.g. added after the settings were saved) with defaults
+void checkSensorSettingsPrefs() {
+    if (SHT45_PRECISION < SHT45Precision::High || SHT45_PRECISION > SHT45Precision::Low) {
+        SHT45_PRECISION = SHT45Precision::High;
+    }
+    if (SHT45_OVERSAMPLING < 1 || SHT45_OVERSAMPLING > SHT45_MAX_OVERSAMPLING) {
+        SHT45_OVERSAMPLING = 1;
+    }
+    SHT45_SPREAD = SHT45_SPREAD ? 1 : 0;
+    if (SKY_NOISE_WINDOW < 2 || SKY_NOISE_WINDOW > STAT_MAX_WINDOW) {
+        SKY_NOISE_WINDOW = 40;
+    }
+    SKY_HIGH_RATE = SKY_HIGH_RATE ? 1 : 0;
+    FUSION_ENABLED = FUSION_ENABLED ? 1 : 0;
+}
+
+void initSensorSettingsPrefs() {
+    sensorSettingsPrefs.begin("sensorPrefs", false);
+    // Default values for current firmware
+    std::fill(std::begin(sensorSettings), std::end(sensorSettings), 0);
+    SHT45_PRECISION = SHT45Precision::High;
+    SHT45_OVERSAMPLING = 1;
+    SHT45_SPREAD = 0;
+    SKY_NOISE_WINDOW = 40;
+    SKY_HIGH_RATE = 0;
+    FUSION_ENABLED = 0;
+    checkSensorSettingsPrefs();
+    loadSensorSettingsPrefs();
+}
+
+void loadSensorSettingsPrefs() {
+    if (sensorSettingsPrefs.isKey("settings")) {
+        sensorSettingsPrefs.getBytes("settings", sensorSettings, sizeof(sensorSettings));
+        checkSensorSettingsPrefs();
+    }
+}
+
+void saveSensorSettingsPrefs() {
+    checkSensorSettingsPrefs();
+    sensorSettingsPrefs.putBytes("settings", sensorSettings, sizeof(sensorSettings));
+}
@@ -0,0 +1,31 @@
+#pragma once
+
+#include "main.h"
+#include <Arduino.h>
+#include <String.h>
+
+#define SHT45_PRECISION sensorSettings[shtPrecision]
+#define SHT45_OVERSAMPLING sensorSettings[shtOversampling]
+#define SHT45_SPREAD sensorSettings[shtSpread]
+#define SKY_NOISE_WINDOW sensorSettings[skyNoiseWindow]
+#define SKY_HIGH_RATE sensorSettings[skyHighRate]
+#define FUSION_ENABLED sensorSettings[fusionEnabled]
+
+#define SENSOR_SETTINGS_SIZE 64
+
+extern float sensorSettings[SENSOR_SETTINGS_SIZE];
+
+enum SensorSettings {
+
+    shtPrecision = 0,
+    shtOversampling = 1,
+    shtSpread = 2,
+    skyNoiseWindow = 3,
+    skyHighRate = 4,
+    fusionEnabled = 5,
+};
+
+void checkSensorSettingsPrefs();
+void initSensorSettingsPrefs();
+void loadSensorSettingsPrefs();
+void saveSensorSettingsPrefs();
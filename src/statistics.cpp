@@ -0,0 +1,50 @@
+#include "statistics.h"
+
+void RollingStatistics::setWindow(int size) {
+    window = constrain(size, 2, STAT_MAX_WINDOW);
+    clear();
+}
+
+void RollingStatistics::clear() {
+    head = 0;
+    count = 0;
+    mean = 0;
+    m2 = 0;
+}
+
+void RollingStatistics::recompute() {
+    float sum = 0;
+    for (int i = 0; i < count; i++) {
+        sum += values[i];
+    }
+    mean = sum / count;
+    m2 = 0;
+    for (int i = 0; i < count; i++) {
+        float d = values[i] - mean;
+        m2 += d * d;
+    }
+}
+
+void RollingStatistics::add(float value) {
+    if (count < window) {
+        // Growing window - plain Welford update
+        count++;
+        float delta = value - mean;
+        mean += delta / count;
+        m2 += delta * (value - mean);
+    } else {
+        // Full window - replace the oldest value
+        float old = values[head];
+        float oldMean = mean;
+        mean += (value - old) / count;
+        m2 += (value - old) * (value - mean + old - oldMean);
+        if (m2 < 0) {
+            m2 = 0;
+        }
+    }
+    values[head] = value;
+    head = (head + 1) % window;
+    if (head == 0 && count == window) {
+        recompute();
+    }
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <Arduino.h>
+
+// Maximum sliding window length
+#define STAT_MAX_WINDOW 240
+
+// Sliding window mean/variance (Welford), O(1) per sample
+class RollingStatistics {
+  private:
+    float values[STAT_MAX_WINDOW];
+    int window;
+    int head = 0;
+    int count = 0;
+    float mean = 0;
+    // Sum of squared deviations from the mean
+    float m2 = 0;
+    // Rebuild sums from the buffer once per window to drop accumulated rounding
+    void recompute();
+
+  public:
+    RollingStatistics(int size = 40) { setWindow(size); }
+    // Change window length, clears the statistics
+    void setWindow(int size);
+    int getWindow() { return window; }
+    void add(float value);
+    void clear();
+    int getCount() { return count; }
+    float getMean() { return mean; }
+    float getM2() { return m2; }
+    float getVariance() { return count > 1 ? m2 / (count - 1) : 0; }
+    // Sum of squares of the window values
+    float getPower() { return m2 + count * mean * mean; }
+};
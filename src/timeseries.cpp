@@ -0,0 +1,426 @@
+#include "timeseries.h"
+
+void TimeBucketLevel::clear() {
+    current = 0;
+    filled = 0;
+    started = false;
+    baseSum = 0;
+    baseCount = 0;
+}
+
+void TimeBucketLevel::add(float value, double sum, uint32_t count, unsigned long now, uint32_t samples, float peak) {
+    uint32_t b = now / (seconds * 1000UL);
+    // First sample or millis() wrap - start the history over
+    if (!started || b < current) {
+        started = true;
+        filled = 0;
+        current = b;
+        baseSum = sum - (double)value * samples;
+        baseCount = count - samples;
+        buckets[current % size] = {baseSum, baseCount, NAN, NAN};
+    }
+    // Close the buckets passed since the last sample, at most one full ring
+    if (b > current) {
+        uint32_t steps = min(b - current, (uint32_t)size);
+        TimeBucket closed = {sum - (double)value * samples, count - samples, NAN, NAN};
+        for (uint32_t j = b - steps + 1; j <= b; j++) {
+            buckets[j % size] = closed;
+        }
+        filled = min((uint32_t)filled + (b - current), (uint32_t)(size - 1));
+        current = b;
+    }
+    TimeBucket &bucket = buckets[current % size];
+    bucket.sum = sum;
+    bucket.count = count;
+    if (std::isnan(peak)) {
+        peak = value;
+    }
+    bucket.min = std::isnan(bucket.min) ? value : min(bucket.min, value);
+    bucket.max = std::isnan(bucket.max) ? peak : max(bucket.max, peak);
+}
+
+void TimeBucketLevel::cumulative(int64_t j, double sum, uint32_t count, double *cumSum, double *cumCount) {
+    if (j >= (int64_t)current) {
+        // No samples after the current bucket
+        *cumSum = sum;
+        *cumCount = count;
+    } else if (j >= (int64_t)current - filled) {
+        *cumSum = buckets[j % size].sum;
+        *cumCount = buckets[j % size].count;
+    } else if (filled < size - 1) {
+        // Before the history start
+        *cumSum = baseSum;
+        *cumCount = baseCount;
+    } else {
+        // Beyond the ring, clamped to the oldest bucket
+        TimeBucket &oldest = buckets[(current - filled) % size];
+        *cumSum = oldest.sum;
+        *cumCount = oldest.count;
+    }
+}
+
+void TimeBucketLevel::range(uint32_t period, double sum, uint32_t count, unsigned long now, double *rangeSum, double *rangeCount) {
+    *rangeSum = 0;
+    *rangeCount = 0;
+    if (!started) {
+        return;
+    }
+    uint32_t length = seconds * 1000UL;
+    int64_t b = now / length;
+    // Time left for the completed buckets after the elapsed part of the present one
+    int64_t rest = (int64_t)period * 1000 - (int64_t)(now % length);
+    int64_t k = rest > 0 ? rest / length : 0;
+    double fraction = rest > 0 ? (double)(rest - k * length) / length : 0;
+    double endSum, endCount, edgeSum, edgeCount;
+    // Whole buckets b - k .. b
+    cumulative(b - k - 1, sum, count, &endSum, &endCount);
+    *rangeSum = sum - endSum;
+    *rangeCount = count - endCount;
+    // Part of the bucket at the window edge, samples assumed evenly spread
+    if (fraction > 0) {
+        cumulative(b - k - 2, sum, count, &edgeSum, &edgeCount);
+        *rangeSum += fraction * (endSum - edgeSum);
+        *rangeCount += fraction * (endCount - edgeCount);
+    }
+}
+
+void TimeBucketLevel::extremes(uint32_t period, unsigned long now, float *rangeMin, float *rangeMax) {
+    *rangeMin = NAN;
+    *rangeMax = NAN;
+    if (!started) {
+        return;
+    }
+    uint32_t length = seconds * 1000UL;
+    int64_t b = now / length;
+    int64_t rest = (int64_t)period * 1000 - (int64_t)(now % length);
+    int64_t first = rest > 0 ? b - (rest + length - 1) / length : b;
+    first = max(first, (int64_t)current - filled);
+    for (int64_t j = first; j <= min(b, (int64_t)current); j++) {
+        TimeBucket &bucket = buckets[j % size];
+        if (!std::isnan(bucket.min)) {
+            *rangeMin = std::isnan(*rangeMin) ? bucket.min : min(*rangeMin, bucket.min);
+            *rangeMax = std::isnan(*rangeMax) ? bucket.max : max(*rangeMax, bucket.max);
+        }
+    }
+}
+
+int TimeBucketLevel::collect(uint32_t period, double sum, uint32_t count, unsigned long now, float *means, float *weights) {
+    if (!started) {
+        return 0;
+    }
+    uint32_t length = seconds * 1000UL;
+    int64_t b = now / length;
+    int64_t rest = (int64_t)period * 1000 - (int64_t)(now % length);
+    int64_t k = rest > 0 ? rest / length : 0;
+    double fraction = rest > 0 ? (double)(rest - k * length) / length : 0;
+    int64_t first = fraction > 0 ? b - k - 1 : b - k;
+    int n = 0;
+    double endSum, endCount, startSum, startCount;
+    cumulative(b, sum, count, &endSum, &endCount);
+    for (int64_t j = b; j >= first; j--) {
+        cumulative(j - 1, sum, count, &startSum, &startCount);
+        double c = endCount - startCount;
+        if (c > 0) {
+            means[n] = (endSum - startSum) / c;
+            weights[n] = j == b - k - 1 ? fraction * c : c;
+            n++;
+        }
+        endSum = startSum;
+        endCount = startCount;
+        // History exhausted
+        if (j <= (int64_t)current - filled) {
+            break;
+        }
+    }
+    return n;
+}
+
+bool TimeBucketLevel::bucket(uint32_t age, double sum, uint32_t count, unsigned long now, double *bucketSum, uint32_t *bucketCount, float *bucketMax) {
+    int64_t j = (int64_t)(now / (seconds * 1000UL)) - age;
+    if (!started || j > (int64_t)current || j < (int64_t)current - filled) {
+        return false;
+    }
+    double endSum, endCount, startSum, startCount;
+    cumulative(j, sum, count, &endSum, &endCount);
+    cumulative(j - 1, sum, count, &startSum, &startCount);
+    *bucketSum = endSum - startSum;
+    *bucketCount = endCount - startCount;
+    *bucketMax = buckets[j % size].max;
+    return *bucketCount > 0 && !std::isnan(*bucketMax);
+}
+
+TimeBucketLevel *TimeSeries::level(uint32_t period) {
+    return period <= fine.getSpan() ? &fine : &coarse;
+}
+
+void TimeSeries::clear() {
+    fine.clear();
+    coarse.clear();
+    sampleHead = 0;
+    sampleCount = 0;
+    sum = 0;
+    count = 0;
+    last = 0;
+    ema = 0;
+}
+
+void TimeSeries::add(float value, unsigned long now) {
+    if (count == 0 || emaPeriod == 0) {
+        ema = value;
+    } else {
+        // Time based smoothing factor, irregular updates keep the time constant
+        ema += (1 - expf(-(float)(now - lastTime) / (emaPeriod * 1000.f))) * (value - ema);
+    }
+    lastTime = now;
+    sum += value;
+    count++;
+    last = value;
+    samples[sampleHead] = value;
+    sampleTimes[sampleHead] = now;
+    sampleHead = (sampleHead + 1) % TS_SAMPLE_WINDOW;
+    if (sampleCount < TS_SAMPLE_WINDOW) {
+        sampleCount++;
+    }
+    fine.add(value, sum, count, now);
+    coarse.add(value, sum, count, now);
+}
+
+float TimeSeries::getMean(uint32_t period, unsigned long now) {
+    period = min(period, (uint32_t)TS_MAX_PERIOD);
+    if (period == 0) {
+        return last;
+    }
+    double rangeSum, rangeCount;
+    level(period)->range(period, sum, count, now, &rangeSum, &rangeCount);
+    // Less than a sample in the window, e.g. a stalled update - latest value
+    if (rangeCount < 0.5) {
+        return last;
+    }
+    return rangeSum / rangeCount;
+}
+
+float TimeSeries::getMin(uint32_t period, unsigned long now) {
+    period = min(period, (uint32_t)TS_MAX_PERIOD);
+    float rangeMin, rangeMax;
+    level(period)->extremes(period, now, &rangeMin, &rangeMax);
+    return std::isnan(rangeMin) ? last : rangeMin;
+}
+
+float TimeSeries::getMax(uint32_t period, unsigned long now) {
+    period = min(period, (uint32_t)TS_MAX_PERIOD);
+    float rangeMin, rangeMax;
+    level(period)->extremes(period, now, &rangeMin, &rangeMax);
+    return std::isnan(rangeMax) ? last : rangeMax;
+}
+
+int TimeSeries::recent(uint32_t period, unsigned long now, float *values, float *weights) {
+    if (sampleCount == 0) {
+        return 0;
+    }
+    unsigned long start = now - period * 1000UL;
+    int oldest = (sampleHead + TS_SAMPLE_WINDOW - sampleCount) % TS_SAMPLE_WINDOW;
+    // Samples dropped from the window may still be in the period
+    if (sampleCount < count && (long)(sampleTimes[oldest] - start) > 0) {
+        return 0;
+    }
+    int n = 0;
+    for (int i = 0; i < sampleCount; i++) {
+        int j = (oldest + i) % TS_SAMPLE_WINDOW;
+        if ((long)(sampleTimes[j] - start) > 0) {
+            values[n] = samples[j];
+            weights[n] = 1;
+            n++;
+        }
+    }
+    return n;
+}
+
+int TimeSeries::sorted(uint32_t period, unsigned long now, float *means, float *weights, float *total) {
+    period = min(period, (uint32_t)TS_MAX_PERIOD);
+    // Single samples while the window covers the period, a glitch is not averaged into its bucket
+    int n = recent(period, now, means, weights);
+    if (n == 0) {
+        n = level(period)->collect(period, sum, count, now, means, weights);
+    }
+    // Insertion sort, at most a window of samples or a ring of buckets
+    *total = 0;
+    for (int i = 0; i < n; i++) {
+        float m = means[i], w = weights[i];
+        int j = i - 1;
+        while (j >= 0 && means[j] > m) {
+            means[j + 1] = means[j];
+            weights[j + 1] = weights[j];
+            j--;
+        }
+        means[j + 1] = m;
+        weights[j + 1] = w;
+        *total += w;
+    }
+    return n;
+}
+
+float TimeSeries::getMedian(uint32_t period, unsigned long now) {
+    float means[TS_RANK_SIZE], weights[TS_RANK_SIZE], total;
+    int n = sorted(period, now, means, weights, &total);
+    if (period == 0 || total <= 0) {
+        return last;
+    }
+    float acc = 0;
+    for (int i = 0; i < n; i++) {
+        acc += weights[i];
+        if (acc >= total / 2) {
+            return means[i];
+        }
+    }
+    return means[n - 1];
+}
+
+float TimeSeries::getTrimmedMean(uint32_t period, unsigned long now) {
+    float means[TS_RANK_SIZE], weights[TS_RANK_SIZE], total;
+    int n = sorted(period, now, means, weights, &total);
+    if (period == 0 || total <= 0) {
+        return last;
+    }
+    float low = total * TS_TRIM_FRACTION;
+    float high = total - low;
+    float acc = 0, s = 0, w = 0;
+    for (int i = 0; i < n; i++) {
+        // Part of the bucket weight inside [low, high]
+        float part = min(acc + weights[i], high) - max(acc, low);
+        if (part > 0) {
+            s += part * means[i];
+            w += part;
+        }
+        acc += weights[i];
+    }
+    return w > 0 ? s / w : last;
+}
+
+float TimeSeries::getAverage(uint8_t kernel, uint32_t period, unsigned long now) {
+    switch (kernel) {
+    case AverageKernel::Ema:
+        return period == 0 ? last : ema;
+    case AverageKernel::Median:
+        return getMedian(period, now);
+    case AverageKernel::Trimmed:
+        return getTrimmedMean(period, now);
+    case AverageKernel::Max:
+        return period == 0 ? last : getMax(period, now);
+    }
+    return getMean(period, now);
+}
+
+void TimeSeries::checkpoint(TimeSeriesCheckpoint *cp, unsigned long now) {
+    double sums[TS_COARSE_BUCKETS], fineSums[TS_FINE_BUCKETS];
+    uint32_t counts[TS_COARSE_BUCKETS], fineCounts[TS_FINE_BUCKETS];
+    float peaks[TS_COARSE_BUCKETS], finePeaks[TS_FINE_BUCKETS];
+    float spread = 0;
+    cp->last = last;
+    cp->ema = ema;
+    cp->phase = now % (TS_COARSE_SECONDS * 1000UL);
+    for (int i = 0; i < TS_COARSE_BUCKETS; i++) {
+        if (!coarse.bucket(i, sum, count, now, &sums[i], &counts[i], &peaks[i])) {
+            counts[i] = 0;
+            continue;
+        }
+        spread = max(spread, fabsf(sums[i] / counts[i] - last));
+        spread = max(spread, fabsf(peaks[i] - last));
+    }
+    for (int i = 0; i < TS_FINE_BUCKETS; i++) {
+        if (!fine.bucket(i, sum, count, now, &fineSums[i], &fineCounts[i], &finePeaks[i])) {
+            fineCounts[i] = 0;
+            continue;
+        }
+        spread = max(spread, fabsf(fineSums[i] / fineCounts[i] - last));
+        spread = max(spread, fabsf(finePeaks[i] - last));
+    }
+    // Step fitting the largest deviation from the latest value
+    cp->scale = spread > 0 ? spread / INT16_MAX : 1;
+    for (int i = 0; i < TS_COARSE_BUCKETS; i++) {
+        cp->count[i] = min(counts[i], (uint32_t)UINT8_MAX);
+        cp->mean[i] = counts[i] ? lroundf((sums[i] / counts[i] - last) / cp->scale) : 0;
+        cp->max[i] = counts[i] ? lroundf((peaks[i] - last) / cp->scale) : 0;
+    }
+    for (int i = 0; i < TS_FINE_BUCKETS; i++) {
+        cp->fineCount[i] = min(fineCounts[i], (uint32_t)UINT8_MAX);
+        cp->fineMean[i] = fineCounts[i] ? lroundf((fineSums[i] / fineCounts[i] - last) / cp->scale) : 0;
+        cp->fineMax[i] = fineCounts[i] ? lroundf((finePeaks[i] - last) / cp->scale) : 0;
+    }
+}
+
+void TimeSeries::replay(float value, uint32_t samples, float peak, unsigned long now) {
+    sum += (double)value * samples;
+    count += samples;
+    fine.add(value, sum, count, now, samples, peak);
+    coarse.add(value, sum, count, now, samples, peak);
+}
+
+void TimeSeries::restore(const TimeSeriesCheckpoint *cp, uint32_t age, unsigned long now) {
+    clear();
+    unsigned long saved = now - age * 1000UL;
+    unsigned long length = TS_COARSE_SECONDS * 1000UL;
+    unsigned long fineLength = TS_FINE_SECONDS * 1000UL;
+    unsigned long finePhase = cp->phase % fineLength;
+    // Time back from the checkpoint where the fine history starts
+    unsigned long fineStart = finePhase + (TS_FINE_BUCKETS - 1) * fineLength;
+    int f = TS_FINE_BUCKETS - 1;
+    // Oldest first, each bucket as its samples at the bucket middle. Fine buckets stand for the
+    // newest part of their coarse bucket, the rest of it goes first
+    for (int i = TS_COARSE_BUCKETS - 1; i >= 0; i--) {
+        unsigned long newer = i == 0 ? 0 : cp->phase + (i - 1) * length;
+        unsigned long older = cp->phase + i * length;
+        float value = cp->last + cp->mean[i] * cp->scale;
+        double rest = (double)value * cp->count[i];
+        int32_t restCount = cp->count[i];
+        int first = f;
+        while (f >= 0 && (f == 0 ? 0 : finePhase + (f - 1) * fineLength) >= newer) {
+            rest -= (double)(cp->last + cp->fineMean[f] * cp->scale) * cp->fineCount[f];
+            restCount -= cp->fineCount[f];
+            f--;
+        }
+        unsigned long restNewer = max(newer, fineStart);
+        if (restCount > 0 && restNewer < older) {
+            unsigned long back = (restNewer + older) / 2;
+            if (age * 1000UL + back < now) {
+                replay(rest / restCount, restCount, cp->last + cp->max[i] * cp->scale, saved - back);
+            }
+        }
+        for (int j = first; j > f; j--) {
+            unsigned long back = j == 0 ? finePhase / 2 : finePhase + (2 * j - 1) * fineLength / 2;
+            if (cp->fineCount[j] == 0 || age * 1000UL + back >= now) {
+                continue;
+            }
+            replay(cp->last + cp->fineMean[j] * cp->scale, cp->fineCount[j], cp->last + cp->fineMax[j] * cp->scale, saved - back);
+        }
+    }
+    if (count > 0) {
+        last = cp->last;
+        ema = cp->ema;
+        lastTime = saved;
+    }
+}
+
+String averageKernelAsString(uint8_t kernel) {
+    switch (kernel) {
+    case AverageKernel::Ema:
+        return "ema";
+    case AverageKernel::Median:
+        return "median";
+    case AverageKernel::Trimmed:
+        return "trimmed";
+    case AverageKernel::Max:
+        return "max";
+    }
+    return "mean";
+}
+
+uint8_t averageKernelFromString(String name, uint8_t fallback) {
+    name.trim();
+    name.toLowerCase();
+    for (uint8_t kernel = AverageKernel::Mean; kernel <= AverageKernel::Max; kernel++) {
+        if (name == averageKernelAsString(kernel)) {
+            return kernel;
+        }
+    }
+    return fallback;
+}
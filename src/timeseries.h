@@ -0,0 +1,153 @@
+#pragma once
+
+#include <Arduino.h>
+
+// Fine level, 15 s buckets for the last 10 minutes
+#define TS_FINE_SECONDS 15
+#define TS_FINE_BUCKETS 40
+// Coarse level, 5 min buckets for the last 4 hours
+#define TS_COARSE_SECONDS 300
+#define TS_COARSE_BUCKETS 48
+// Longest averaging period served
+#define TS_MAX_PERIOD ((TS_COARSE_BUCKETS - 1) * TS_COARSE_SECONDS)
+// Share of the weight dropped at each end by the trimmed mean
+#define TS_TRIM_FRACTION 0.1
+// Latest samples ranked by the median and trimmed mean while they reach back over the period
+#define TS_SAMPLE_WINDOW 64
+// Values ranked per query, samples or bucket means
+#define TS_RANK_SIZE (TS_SAMPLE_WINDOW > TS_COARSE_BUCKETS + 1 ? TS_SAMPLE_WINDOW : TS_COARSE_BUCKETS + 1)
+// Series clock lead over millis(), restored history needs times before boot
+#define TS_CLOCK_OFFSET 86400000UL
+
+// Default time of the series, ms
+inline unsigned long timeseriesClock() { return millis() + TS_CLOCK_OFFSET; }
+
+// Averaging kernel of a channel
+class AverageKernel {
+  public:
+    static const uint8_t Mean = 0;
+    // Exponential moving average, time constant of the averaging period
+    static const uint8_t Ema = 1;
+    // Median of the samples, weighted median of the bucket means past the sample window
+    static const uint8_t Median = 2;
+    // Mean without the TS_TRIM_FRACTION tails, of the samples or past the sample window of the bucket means
+    static const uint8_t Trimmed = 3;
+    static const uint8_t Max = 4;
+};
+
+// Time bucket, sums and counts are cumulative up to the bucket end so any range is a difference
+struct TimeBucket {
+    double sum;
+    uint32_t count;
+    float min;
+    float max;
+};
+
+// Bucket history of a TimeSeries quantized around its latest value, about 450 bytes for a warm start
+struct TimeSeriesCheckpoint {
+    float last;
+    float ema;
+    // Value of a quantization step
+    float scale;
+    // Elapsed part of the newest coarse bucket, ms, the fine one is its remainder
+    uint32_t phase;
+    // Bucket means and peaks, newest first
+    int16_t mean[TS_COARSE_BUCKETS];
+    int16_t max[TS_COARSE_BUCKETS];
+    // Samples per bucket, saturated, 0 for an empty bucket
+    uint8_t count[TS_COARSE_BUCKETS];
+    // Same for the fine level, averages up to its span are served from it
+    int16_t fineMean[TS_FINE_BUCKETS];
+    int16_t fineMax[TS_FINE_BUCKETS];
+    uint8_t fineCount[TS_FINE_BUCKETS];
+};
+
+// Ring of fixed length time buckets
+class TimeBucketLevel {
+  private:
+    TimeBucket *buckets;
+    uint16_t size;
+    uint16_t seconds;
+    // Absolute number of the current bucket (time / bucket length)
+    uint32_t current = 0;
+    // Completed buckets available
+    uint16_t filled = 0;
+    bool started = false;
+    // Series totals before the first bucket
+    double baseSum = 0;
+    uint32_t baseCount = 0;
+    // Cumulative sum and count at the end of bucket j
+    void cumulative(int64_t j, double sum, uint32_t count, double *cumSum, double *cumCount);
+
+  public:
+    TimeBucketLevel(TimeBucket *storage, uint16_t buckets, uint16_t bucketSeconds) : buckets(storage), size(buckets), seconds(bucketSeconds) {}
+    void clear();
+    // Account a sample, or samples of the given mean and peak, sum and count are the series totals including them
+    void add(float value, double sum, uint32_t count, unsigned long now, uint32_t samples = 1, float peak = NAN);
+    // Sum and (fractional) count of the last period seconds
+    void range(uint32_t period, double sum, uint32_t count, unsigned long now, double *rangeSum, double *rangeCount);
+    // Extremes of the buckets touching the last period seconds, O(buckets)
+    void extremes(uint32_t period, unsigned long now, float *rangeMin, float *rangeMax);
+    // Means and weights (sample counts, edge bucket pro-rated) of the buckets in the last period seconds, O(buckets)
+    int collect(uint32_t period, double sum, uint32_t count, unsigned long now, float *means, float *weights);
+    // Sum, samples and peak of the bucket age buckets before the present one, false if empty or not held
+    bool bucket(uint32_t age, double sum, uint32_t count, unsigned long now, double *bucketSum, uint32_t *bucketCount, float *bucketMax);
+    uint16_t getSeconds() { return seconds; }
+    // History length in seconds
+    uint32_t getSpan() { return (uint32_t)(size - 1) * seconds; }
+};
+
+// Time-correct sliding averages of a channel over any period up to TS_MAX_PERIOD, O(1) per sample and query
+class TimeSeries {
+  private:
+    TimeBucket fineBuckets[TS_FINE_BUCKETS];
+    TimeBucket coarseBuckets[TS_COARSE_BUCKETS];
+    TimeBucketLevel fine = TimeBucketLevel(fineBuckets, TS_FINE_BUCKETS, TS_FINE_SECONDS);
+    TimeBucketLevel coarse = TimeBucketLevel(coarseBuckets, TS_COARSE_BUCKETS, TS_COARSE_SECONDS);
+    double sum = 0;
+    uint32_t count = 0;
+    float last = 0;
+    unsigned long lastTime = 0;
+    // Exponential moving average and its time constant, seconds
+    float ema = 0;
+    uint32_t emaPeriod = 0;
+    // Latest samples and their times, a ring of TS_SAMPLE_WINDOW
+    float samples[TS_SAMPLE_WINDOW];
+    unsigned long sampleTimes[TS_SAMPLE_WINDOW];
+    uint16_t sampleHead = 0;
+    uint16_t sampleCount = 0;
+    TimeBucketLevel *level(uint32_t period);
+    // Samples of the period with unit weights, 0 if the window does not reach back over the period
+    int recent(uint32_t period, unsigned long now, float *values, float *weights);
+    // Account samples of the given mean and peak on both levels, restore of a checkpoint
+    void replay(float value, uint32_t samples, float peak, unsigned long now);
+    // Sorted samples, or bucket means, and weights of the period
+    int sorted(uint32_t period, unsigned long now, float *means, float *weights, float *total);
+
+  public:
+    TimeSeries() { clear(); }
+    void clear();
+    void add(float value, unsigned long now = timeseriesClock());
+    // Mean of the last period seconds, the latest value for period 0
+    float getMean(uint32_t period, unsigned long now = timeseriesClock());
+    float getMin(uint32_t period, unsigned long now = timeseriesClock());
+    float getMax(uint32_t period, unsigned long now = timeseriesClock());
+    float getMedian(uint32_t period, unsigned long now = timeseriesClock());
+    float getTrimmedMean(uint32_t period, unsigned long now = timeseriesClock());
+    void setEmaPeriod(uint32_t period) { emaPeriod = period; }
+    float getEma() { return ema; }
+    // Average of the last period seconds with the given AverageKernel
+    float getAverage(uint8_t kernel, uint32_t period, unsigned long now = timeseriesClock());
+    float getLast() { return last; }
+    uint32_t getCount() { return count; }
+    // Bucket length used for the period
+    uint16_t getResolution(uint32_t period) { return level(period)->getSeconds(); }
+    // Fine and coarse buckets, the EMA and the latest value
+    void checkpoint(TimeSeriesCheckpoint *cp, unsigned long now = timeseriesClock());
+    // Series of a checkpoint taken age seconds ago, single samples are not kept
+    void restore(const TimeSeriesCheckpoint *cp, uint32_t age, unsigned long now = timeseriesClock());
+};
+
+String averageKernelAsString(uint8_t kernel);
+// Kernel by name, fallback for an unknown one
+uint8_t averageKernelFromString(String name, uint8_t fallback);
@@ -0,0 +1,115 @@
+#include "trend.h"
+
+static const uint16_t trendWindows[TREND_WINDOWS] = TREND_WINDOW_LENGTHS;
+
+static const char *trendChannels[TREND_CHANNELS] = {"pressure", "temperature", "humidity", "sky_temperature"};
+
+const char *trendChannelName(int channel) {
+    return trendChannels[channel];
+}
+
+void SlidingRegression::clear() {
+    started = false;
+    current = 0;
+    first = 0;
+    reference = 0;
+    for (int i = 0; i < TREND_BUCKETS; i++) {
+        buckets[i] = {0, 0, 0, 0, 0};
+    }
+    for (int w = 0; w < TREND_WINDOWS; w++) {
+        windows[w] = {0, 0, 0, 0, 0};
+    }
+}
+
+void SlidingRegression::remove(RegressionSums &sums, const Bucket &bucket, double offset) {
+    // Bucket times are offset seconds from the window origin
+    sums.n -= bucket.n;
+    sums.t -= bucket.t + bucket.n * offset;
+    sums.y -= bucket.y;
+    sums.tt -= bucket.tt + 2 * offset * bucket.t + bucket.n * offset * offset;
+    sums.ty -= bucket.ty + offset * bucket.y;
+}
+
+void SlidingRegression::advance(uint32_t b) {
+    // Longer gaps leave nothing in any window
+    if (b - current >= TREND_BUCKETS) {
+        float keep = reference;
+        clear();
+        started = true;
+        reference = keep;
+        current = b;
+        first = b;
+        return;
+    }
+    while (current < b) {
+        current++;
+        for (int w = 0; w < TREND_WINDOWS; w++) {
+            RegressionSums &s = windows[w];
+            // New time origin one bucket later
+            s.tt -= 2. * TREND_BUCKET * s.t - s.n * TREND_BUCKET * TREND_BUCKET;
+            s.t -= s.n * TREND_BUCKET;
+            s.ty -= (double)TREND_BUCKET * s.y;
+            // Bucket falling out of the window
+            uint32_t length = trendWindows[w];
+            if (current >= first + length) {
+                remove(s, buckets[(current - length) % TREND_BUCKETS], -(double)length * TREND_BUCKET);
+            }
+        }
+        buckets[current % TREND_BUCKETS] = {0, 0, 0, 0, 0};
+    }
+}
+
+void SlidingRegression::add(float value, unsigned long now) {
+    if (std::isnan(value)) {
+        return;
+    }
+    uint32_t b = now / (TREND_BUCKET * 1000UL);
+    // First sample or millis() wrap - start over
+    if (!started || b < current) {
+        clear();
+        started = true;
+        reference = value;
+        current = b;
+        first = b;
+    }
+    advance(b);
+    float t = (now % (TREND_BUCKET * 1000UL)) / 1000.f;
+    float y = value - reference;
+    Bucket &bucket = buckets[current % TREND_BUCKETS];
+    bucket.n++;
+    bucket.t += t;
+    bucket.y += y;
+    bucket.tt += t * t;
+    bucket.ty += t * y;
+    for (int w = 0; w < TREND_WINDOWS; w++) {
+        RegressionSums &s = windows[w];
+        s.n++;
+        s.t += t;
+        s.y += y;
+        s.tt += t * t;
+        s.ty += t * y;
+    }
+}
+
+float SlidingRegression::getSlope(uint8_t window) {
+    RegressionSums &s = windows[window];
+    if (s.n < 2 || getCoverage(window) < TREND_MIN_COVERAGE) {
+        return NAN;
+    }
+    double denominator = s.n * s.tt - s.t * s.t;
+    if (denominator <= 0) {
+        return NAN;
+    }
+    return (s.n * s.ty - s.t * s.y) / denominator;
+}
+
+uint32_t SlidingRegression::getWindow(uint8_t window) {
+    return trendWindows[window] * TREND_BUCKET;
+}
+
+float SlidingRegression::getCoverage(uint8_t window) {
+    if (!started) {
+        return 0;
+    }
+    return min((float)(current - first + 1) / trendWindows[window], 1.f);
+}
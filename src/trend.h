@@ -0,0 +1,77 @@
+#pragma once
+
+#include <Arduino.h>
+
+// Bucket length, seconds, windows slide by whole buckets
+#define TREND_BUCKET 60
+// Longest window, 3 hours of buckets
+#define TREND_BUCKETS 180
+// Least squares windows, buckets
+#define TREND_WINDOWS 2
+#define TREND_WINDOW_LENGTHS {60, 180}
+// Share of a window that must be covered before a slope is reported
+#define TREND_MIN_COVERAGE 0.5
+
+// Trended channels
+class TrendChannel {
+  public:
+    static const int Pressure = 0;
+    static const int Temperature = 1;
+    static const int Humidity = 2;
+    static const int SkyTemperature = 3;
+};
+#define TREND_CHANNELS 4
+
+class TrendWindow {
+  public:
+    static const uint8_t Hour = 0;
+    static const uint8_t ThreeHours = 1;
+};
+
+// Least squares sums, times relative to the current bucket start
+struct RegressionSums {
+    double n;
+    double t;
+    double y;
+    double tt;
+    double ty;
+};
+
+// Linear regression slope over sliding time windows, O(1) per sample and query
+// Samples are summed per bucket, the windows add and drop whole buckets and shift their time origin
+// with the bucket instead of rescanning the samples
+class SlidingRegression {
+  private:
+    // Bucket sums, times relative to the bucket start, values to the reference
+    struct Bucket {
+        uint16_t n;
+        float t;
+        float y;
+        float tt;
+        float ty;
+    };
+    Bucket buckets[TREND_BUCKETS];
+    RegressionSums windows[TREND_WINDOWS];
+    // Absolute number of the current bucket and of the first one after a (re)start
+    uint32_t current = 0;
+    uint32_t first = 0;
+    bool started = false;
+    // First value, keeps the sums small
+    float reference = 0;
+    void advance(uint32_t b);
+    void remove(RegressionSums &sums, const Bucket &bucket, double offset);
+
+  public:
+    SlidingRegression() { clear(); }
+    void clear();
+    void add(float value, unsigned long now = millis());
+    // Slope of the window in value units per second, NaN until the window is covered well enough
+    float getSlope(uint8_t window);
+    // Window length, seconds
+    uint32_t getWindow(uint8_t window);
+    // Covered part of the window, 0..1
+    float getCoverage(uint8_t window);
+    uint32_t getCount(uint8_t window) { return windows[window].n; }
+};
+
+const char *trendChannelName(int channel);
@@ -0,0 +1,468 @@
+#include "tslog.h"
+#include "config.h"
+#include "history.h"
+#include "rollup.h"
+#include <Preferences.h>
+#include <time.h>
+
+Preferences tslogPrefs;
+
+TsLog tslog;
+TsLogPartition tslogPartition;
+
+// Logged channels, HistoryChannel source, decimals kept and minute aggregation
+static const struct {
+    int source;
+    uint8_t decimals;
+    uint8_t aggregate;
+} tslogChannels[TSLOG_CHANNELS] = {
+    {HistoryChannel::Temperature, 2, TsLogAggregate::Mean},
+    {HistoryChannel::Humidity, 1, TsLogAggregate::Mean},
+    {HistoryChannel::DewPoint, 2, TsLogAggregate::Mean},
+    {HistoryChannel::Bmp280Pressure, 1, TsLogAggregate::Mean},
+    {HistoryChannel::SkyTemperature, 2, TsLogAggregate::Mean},
+    {HistoryChannel::Mlx90614Ambient, 2, TsLogAggregate::Mean},
+    {HistoryChannel::Mlx90614Object, 2, TsLogAggregate::Mean},
+    {HistoryChannel::CloudCover, 1, TsLogAggregate::Mean},
+    {HistoryChannel::CloudClass, 0, TsLogAggregate::Last},
+    {HistoryChannel::SkyQuality, 2, TsLogAggregate::Mean},
+    {HistoryChannel::RainRate, 2, TsLogAggregate::Max},
+    {HistoryChannel::WindSpeed, 1, TsLogAggregate::Mean},
+    {HistoryChannel::WindGust, 1, TsLogAggregate::Max},
+    {HistoryChannel::WindDirection, 0, TsLogAggregate::Last},
+    {HistoryChannel::Turbulence, 1, TsLogAggregate::Mean},
+    {HistoryChannel::NoiseDb, 1, TsLogAggregate::Mean}};
+
+static const float tslogScale[] = {1, 10, 100};
+
+uint16_t tslogCrc(const void *data, uint32_t size) {
+    // CRC-16/CCITT-FALSE
+    const uint8_t *p = (const uint8_t *)data;
+    uint16_t crc = 0xffff;
+    while (size--) {
+        crc ^= (uint16_t)*p++ << 8;
+        for (int i = 0; i < 8; i++) {
+            crc = crc & 0x8000 ? (crc << 1) ^ 0x1021 : crc << 1;
+        }
+    }
+    return crc;
+}
+
+int16_t tslogQuantize(float value, int channel) {
+    float scaled = roundf(value * tslogScale[tslogChannels[channel].decimals]);
+    if (std::isnan(scaled) || scaled <= TSLOG_INVALID || scaled > INT16_MAX) {
+        return TSLOG_INVALID;
+    }
+    return (int16_t)scaled;
+}
+
+float tslogDequantize(int16_t value, int channel) {
+    if (value == TSLOG_INVALID) {
+        return NAN;
+    }
+    return value / tslogScale[tslogChannels[channel].decimals];
+}
+
+float tslogMean(int64_t sum, uint32_t count, int channel) {
+    return (float)sum / count / tslogScale[tslogChannels[channel].decimals];
+}
+
+bool TsLogPartition::begin() {
+    partition = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, (esp_partition_subtype_t)TSLOG_SUBTYPE, TSLOG_PARTITION);
+    return partition != nullptr;
+}
+
+uint32_t TsLogPartition::getSize() {
+    return partition ? partition->size : 0;
+}
+
+bool TsLogPartition::read(uint32_t offset, void *data, uint32_t size) {
+    return esp_partition_read(partition, offset, data, size) == ESP_OK;
+}
+
+bool TsLogPartition::write(uint32_t offset, const void *data, uint32_t size) {
+    return esp_partition_write(partition, offset, data, size) == ESP_OK;
+}
+
+bool TsLogPartition::erase(uint32_t offset, uint32_t size) {
+    return esp_partition_erase_range(partition, offset, size) == ESP_OK;
+}
+
+bool TsLogRamFlash::read(uint32_t offset, void *dst, uint32_t bytes) {
+    if (offset + bytes > size) {
+        return false;
+    }
+    memcpy(dst, data + offset, bytes);
+    return true;
+}
+
+bool TsLogRamFlash::write(uint32_t offset, const void *src, uint32_t bytes) {
+    if (offset + bytes > size) {
+        return false;
+    }
+    // Programming clears bits only
+    const uint8_t *p = (const uint8_t *)src;
+    for (uint32_t i = 0; i < bytes; i++) {
+        data[offset + i] &= p[i];
+    }
+    return true;
+}
+
+bool TsLogRamFlash::erase(uint32_t offset, uint32_t bytes) {
+    if (offset % TSLOG_SECTOR || bytes % TSLOG_SECTOR || offset + bytes > size) {
+        return false;
+    }
+    memset(data + offset, 0xff, bytes);
+    return true;
+}
+
+bool TsLog::readHeader(uint32_t sector, TsLogHeader *h) {
+    counters.read += sizeof(TsLogHeader);
+    return flash->read(offset(sector), h, sizeof(TsLogHeader)) && h->magic == TSLOG_MAGIC && h->version == TSLOG_VERSION &&
+           h->crc == tslogCrc(h, offsetof(TsLogHeader, crc));
+}
+
+bool TsLog::readSummary(uint32_t sector, TsLogSummary *s) {
+    counters.read += sizeof(TsLogSummary);
+    return flash->read(offset(sector) + TSLOG_SUMMARY_OFFSET, s, sizeof(TsLogSummary)) && s->records > 0 &&
+           s->crc == tslogCrc(s, offsetof(TsLogSummary, crc));
+}
+
+bool TsLog::readRecord(uint32_t sector, uint16_t index, TsLogRecord *r) {
+    counters.read += sizeof(TsLogRecord);
+    return flash->read(offset(sector) + sizeof(TsLogHeader) + index * sizeof(TsLogRecord), r, sizeof(TsLogRecord)) &&
+           r->time != 0xffffffff && r->crc == tslogCrc(r, offsetof(TsLogRecord, crc));
+}
+
+void TsLog::clearSummary(TsLogSummary *s) {
+    memset(s, 0, sizeof(TsLogSummary));
+    for (int i = 0; i < TSLOG_CHANNELS; i++) {
+        s->min[i] = INT16_MAX;
+        s->max[i] = INT16_MIN;
+    }
+}
+
+void TsLog::accountSummary(TsLogSummary *s, const TsLogRecord &r) {
+    if (s->records == 0) {
+        s->first = r.time;
+    }
+    s->last = r.time;
+    s->records++;
+    for (int i = 0; i < TSLOG_CHANNELS; i++) {
+        if (r.values[i] != TSLOG_INVALID) {
+            s->min[i] = min(s->min[i], r.values[i]);
+            s->max[i] = max(s->max[i], r.values[i]);
+            s->sum[i] += r.values[i];
+            s->count[i]++;
+        }
+    }
+}
+
+void TsLog::openSector(uint32_t sector, uint32_t seq) {
+    flash->erase(offset(sector), TSLOG_SECTOR);
+    counters.erased += TSLOG_SECTOR;
+    TsLogHeader h = {TSLOG_MAGIC, seq, TSLOG_VERSION, 0, 0xffffffff};
+    h.crc = tslogCrc(&h, offsetof(TsLogHeader, crc));
+    flash->write(offset(sector), &h, sizeof(h));
+    counters.written += sizeof(h);
+    head = sector;
+    sequence = seq;
+    used = 0;
+    clearSummary(&summary);
+}
+
+void TsLog::closeSector() {
+    summary.crc = tslogCrc(&summary, offsetof(TsLogSummary, crc));
+    summary.pad = 0xffff;
+    flash->write(offset(head) + TSLOG_SUMMARY_OFFSET, &summary, sizeof(summary));
+    counters.written += sizeof(summary);
+}
+
+bool TsLog::begin(TsLogFlash *area) {
+    if (!mutex) {
+        mutex = xSemaphoreCreateMutex();
+    }
+    flash = area;
+    sectors = area ? area->getSize() / TSLOG_SECTOR : 0;
+    if (!isReady()) {
+        flash = nullptr;
+        return false;
+    }
+    xSemaphoreTake(mutex, portMAX_DELAY);
+    // Tail is the valid sector with the highest sequence, a sector torn while opened has no valid header
+    bool found = false;
+    TsLogHeader h;
+    for (uint32_t s = 0; s < sectors; s++) {
+        if (readHeader(s, &h) && (!found || h.sequence > sequence)) {
+            found = true;
+            head = s;
+            sequence = h.sequence;
+        }
+    }
+    if (!found) {
+        openSector(0, 1);
+    } else {
+        // Slots up to the last programmed one are used, a torn record is skipped
+        clearSummary(&summary);
+        used = 0;
+        TsLogRecord r;
+        for (uint16_t i = 0; i < TSLOG_RECORDS; i++) {
+            if (readRecord(head, i, &r)) {
+                accountSummary(&summary, r);
+                used = i + 1;
+            } else if (r.time != 0xffffffff) {
+                used = i + 1;
+            }
+        }
+    }
+    xSemaphoreGive(mutex);
+    return true;
+}
+
+void TsLog::format() {
+    if (!isReady()) {
+        return;
+    }
+    xSemaphoreTake(mutex, portMAX_DELAY);
+    flash->erase(0, sectors * TSLOG_SECTOR);
+    counters.erased += sectors * TSLOG_SECTOR;
+    openSector(0, 1);
+    xSemaphoreGive(mutex);
+}
+
+void TsLog::append(const TsLogRecord &record) {
+    if (!isReady()) {
+        return;
+    }
+    xSemaphoreTake(mutex, portMAX_DELAY);
+    if (used >= TSLOG_RECORDS) {
+        // Summary is rewritten with the same bits if a previous close was interrupted
+        closeSector();
+        openSector((head + 1) % sectors, sequence + 1);
+    }
+    TsLogRecord r = record;
+    r.crc = tslogCrc(&r, offsetof(TsLogRecord, crc));
+    flash->write(offset(head) + sizeof(TsLogHeader) + used * sizeof(TsLogRecord), &r, sizeof(r));
+    counters.written += sizeof(r);
+    counters.logical += sizeof(r);
+    used++;
+    accountSummary(&summary, r);
+    xSemaphoreGive(mutex);
+}
+
+void TsLog::scan(uint32_t from, uint32_t to, std::function<void(const TsLogRecord &)> record, std::function<bool(const TsLogSummary &)> whole) {
+    uint32_t now = time(nullptr);
+    if (retention > 0 && now > NTP_TIME_VALID) {
+        from = max(from, now - (uint32_t)retention * 86400);
+    }
+    TsLogHeader h;
+    TsLogSummary s;
+    TsLogRecord r;
+    // Oldest first, the sector after the tail
+    for (uint32_t n = 1; n <= sectors; n++) {
+        uint32_t sector = (head + n) % sectors;
+        bool tail = sector == head;
+        if (!tail && !readHeader(sector, &h)) {
+            continue;
+        }
+        uint16_t records = tail ? used : TSLOG_RECORDS;
+        bool summarized = tail ? summary.records > 0 : readSummary(sector, &s);
+        if (tail) {
+            s = summary;
+        }
+        if (summarized) {
+            if (s.last < from || s.first > to) {
+                counters.skipped++;
+                continue;
+            }
+            if (s.first >= from && s.last <= to && whole && whole(s)) {
+                counters.skipped++;
+                continue;
+            }
+        }
+        for (uint16_t i = 0; i < records; i++) {
+            if (readRecord(sector, i, &r) && r.time >= from && r.time <= to) {
+                record(r);
+            }
+        }
+    }
+}
+
+uint32_t TsLog::query(int channel, uint32_t from, uint32_t to, std::function<void(uint32_t, float)> callback) {
+    if (!isReady() || channel < 0 || channel >= TSLOG_CHANNELS) {
+        return 0;
+    }
+    uint32_t n = 0;
+    xSemaphoreTake(mutex, portMAX_DELAY);
+    scan(from, to, [&](const TsLogRecord &r) {
+        callback(r.time, tslogDequantize(r.values[channel], channel));
+        n++;
+    }, nullptr);
+    xSemaphoreGive(mutex);
+    return n;
+}
+
+uint32_t TsLog::summarize(int channel, uint32_t from, uint32_t to, float *minValue, float *maxValue, float *mean) {
+    *minValue = *maxValue = *mean = NAN;
+    if (!isReady() || channel < 0 || channel >= TSLOG_CHANNELS) {
+        return 0;
+    }
+    int16_t lo = INT16_MAX, hi = INT16_MIN;
+    int64_t sum = 0;
+    uint32_t count = 0;
+    xSemaphoreTake(mutex, portMAX_DELAY);
+    scan(from, to, [&](const TsLogRecord &r) {
+        if (r.values[channel] != TSLOG_INVALID) {
+            lo = min(lo, r.values[channel]);
+            hi = max(hi, r.values[channel]);
+            sum += r.values[channel];
+            count++;
+        }
+    }, [&](const TsLogSummary &s) {
+        if (s.count[channel] > 0) {
+            lo = min(lo, s.min[channel]);
+            hi = max(hi, s.max[channel]);
+            sum += s.sum[channel];
+            count += s.count[channel];
+        }
+        return true;
+    });
+    xSemaphoreGive(mutex);
+    if (count > 0) {
+        *minValue = tslogDequantize(lo, channel);
+        *maxValue = tslogDequantize(hi, channel);
+        *mean = tslogMean(sum, count, channel);
+    }
+    return count;
+}
+
+uint32_t TsLog::replay(std::function<void(const TsLogRecord &)> callback) {
+    if (!isReady()) {
+        return 0;
+    }
+    uint32_t n = 0;
+    xSemaphoreTake(mutex, portMAX_DELAY);
+    scan(0, UINT32_MAX, [&](const TsLogRecord &r) {
+        callback(r);
+        n++;
+    }, nullptr);
+    xSemaphoreGive(mutex);
+    return n;
+}
+
+uint32_t TsLog::getRecords() {
+    if (!isReady()) {
+        return 0;
+    }
+    xSemaphoreTake(mutex, portMAX_DELAY);
+    uint32_t n = 0;
+    scan(0, UINT32_MAX, [&](const TsLogRecord &) { n++; }, [&](const TsLogSummary &s) {
+        n += s.records;
+        return true;
+    });
+    xSemaphoreGive(mutex);
+    return n;
+}
+
+uint32_t TsLog::getOldest() {
+    if (!isReady()) {
+        return 0;
+    }
+    xSemaphoreTake(mutex, portMAX_DELAY);
+    uint32_t oldest = 0;
+    scan(0, UINT32_MAX, [&](const TsLogRecord &r) {
+        oldest = oldest ? min(oldest, r.time) : r.time;
+    }, [&](const TsLogSummary &s) {
+        oldest = oldest ? min(oldest, s.first) : s.first;
+        return true;
+    });
+    xSemaphoreGive(mutex);
+    return oldest;
+}
+
+uint32_t TsLog::getNewest() {
+    return summary.records ? summary.last : 0;
+}
+
+void initTsLog() {
+    tslogPrefs.begin("tslogPrefs", false);
+    tslog.setRetention(tslogPrefs.getUShort("retention", TSLOG_RETENTION_DAYS));
+    if (tslogPartition.begin()) {
+        tslog.begin(&tslogPartition);
+    }
+}
+
+void saveTsLogPrefs() {
+    tslogPrefs.putUShort("retention", tslog.getRetention());
+}
+
+void tslogSample(uint32_t time, const float *values) {
+    static uint32_t minute = 0;
+    static float sum[TSLOG_CHANNELS], extreme[TSLOG_CHANNELS], last[TSLOG_CHANNELS];
+    static uint16_t count[TSLOG_CHANNELS];
+    static uint16_t samples = 0;
+    // Records need wall clock times to stay ordered over reboots
+    if (time <= NTP_TIME_VALID) {
+        return;
+    }
+    if (time / TSLOG_PERIOD != minute) {
+        if (samples > 0) {
+            TsLogRecord r;
+            r.time = minute * TSLOG_PERIOD;
+            r.samples = samples;
+            for (int i = 0; i < TSLOG_CHANNELS; i++) {
+                float value = NAN;
+                if (count[i] > 0) {
+                    switch (tslogChannels[i].aggregate) {
+                    case TsLogAggregate::Max:
+                        value = extreme[i];
+                        break;
+                    case TsLogAggregate::Last:
+                        value = last[i];
+                        break;
+                    default:
+                        value = sum[i] / count[i];
+                    }
+                }
+                r.values[i] = tslogQuantize(value, i);
+            }
+            tslog.append(r);
+            rollups.add(r);
+        }
+        minute = time / TSLOG_PERIOD;
+        samples = 0;
+        for (int i = 0; i < TSLOG_CHANNELS; i++) {
+            sum[i] = 0;
+            count[i] = 0;
+        }
+    }
+    samples++;
+    for (int i = 0; i < TSLOG_CHANNELS; i++) {
+        float value = values[tslogChannels[i].source];
+        if (std::isnan(value)) {
+            continue;
+        }
+        extreme[i] = count[i] ? max(extreme[i], value) : value;
+        last[i] = value;
+        sum[i] += value;
+        count[i]++;
+    }
+}
+
+const char *tslogChannelName(int channel) {
+    return historyChannelName(tslogChannels[channel].source);
+}
+
+int tslogChannelFromString(String name) {
+    int source = historyChannelFromString(name);
+    for (int i = 0; i < TSLOG_CHANNELS; i++) {
+        if (tslogChannels[i].source == source) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+uint8_t tslogChannelDecimals(int channel) {
+    return tslogChannels[channel].decimals;
+}
@@ -0,0 +1,185 @@
+#pragma once
+
+#include <Arduino.h>
+#include <esp_partition.h>
+#include <functional>
+
+// Partition label and subtype in partitions.csv
+#define TSLOG_PARTITION "tslog"
+#define TSLOG_SUBTYPE 0x40
+// Flash erase unit, one log block
+#define TSLOG_SECTOR 4096
+#define TSLOG_MAGIC 0x474c5354
+#define TSLOG_VERSION 1
+// Record period, seconds
+#define TSLOG_PERIOD 60
+// Records older than this are not returned, the ring drops them when it wraps
+#define TSLOG_RETENTION_DAYS 21
+// Quantized value of a missing sample
+#define TSLOG_INVALID INT16_MIN
+
+// Logged channels, a subset of HistoryChannel
+#define TSLOG_CHANNELS 16
+
+// Minute aggregation of a channel
+class TsLogAggregate {
+  public:
+    static const uint8_t Mean = 0;
+    static const uint8_t Max = 1;
+    // Angles and classes are not averaged
+    static const uint8_t Last = 2;
+};
+
+// Sector header, written right after the erase
+struct TsLogHeader {
+    uint32_t magic;
+    // Increments with every opened sector, the highest one is the tail
+    uint32_t sequence;
+    uint16_t version;
+    uint16_t crc;
+    uint32_t reserved;
+};
+
+// One minute of every logged channel, written in one go, a torn write fails the crc
+struct TsLogRecord {
+    uint32_t time;
+    int16_t values[TSLOG_CHANNELS];
+    uint16_t samples;
+    uint16_t crc;
+};
+
+// Sector summary at the sector end, written when the sector is full so scans can skip it
+struct TsLogSummary {
+    uint32_t first;
+    uint32_t last;
+    uint16_t records;
+    uint16_t reserved;
+    int16_t min[TSLOG_CHANNELS];
+    int16_t max[TSLOG_CHANNELS];
+    // Sum and count of the valid values
+    int32_t sum[TSLOG_CHANNELS];
+    uint8_t count[TSLOG_CHANNELS];
+    uint16_t crc;
+    uint16_t pad;
+};
+
+#define TSLOG_SUMMARY_OFFSET (TSLOG_SECTOR - sizeof(TsLogSummary))
+#define TSLOG_RECORDS ((TSLOG_SUMMARY_OFFSET - sizeof(TsLogHeader)) / sizeof(TsLogRecord))
+
+// NOR flash area, writes only clear bits, erase sets a sector to 0xff
+class TsLogFlash {
+  public:
+    virtual ~TsLogFlash() {}
+    virtual uint32_t getSize() = 0;
+    virtual bool read(uint32_t offset, void *data, uint32_t size) = 0;
+    virtual bool write(uint32_t offset, const void *data, uint32_t size) = 0;
+    virtual bool erase(uint32_t offset, uint32_t size) = 0;
+};
+
+// The tslog flash partition
+class TsLogPartition : public TsLogFlash {
+  private:
+    const esp_partition_t *partition = nullptr;
+
+  public:
+    bool begin();
+    uint32_t getSize() override;
+    bool read(uint32_t offset, void *data, uint32_t size) override;
+    bool write(uint32_t offset, const void *data, uint32_t size) override;
+    bool erase(uint32_t offset, uint32_t size) override;
+};
+
+// Partition simulated in RAM with NOR semantics, for benchmarks
+class TsLogRamFlash : public TsLogFlash {
+  private:
+    uint8_t *data = nullptr;
+    uint32_t size = 0;
+
+  public:
+    TsLogRamFlash(uint8_t *storage, uint32_t bytes) : data(storage), size(bytes) {}
+    uint32_t getSize() override { return size; }
+    bool read(uint32_t offset, void *dst, uint32_t bytes) override;
+    bool write(uint32_t offset, const void *src, uint32_t bytes) override;
+    bool erase(uint32_t offset, uint32_t bytes) override;
+};
+
+// Flash traffic since mount
+struct TsLogCounters {
+    // Record payload appended
+    uint32_t logical;
+    // Bytes programmed, records, headers and summaries
+    uint32_t written;
+    uint32_t erased;
+    uint32_t read;
+    // Sectors whose summary let a scan skip the records
+    uint32_t skipped;
+};
+
+// Append-only ring of sectors, each sector erased once per ring turn for even wear
+class TsLog {
+  private:
+    TsLogFlash *flash = nullptr;
+    uint32_t sectors = 0;
+    // Tail sector being appended and its state
+    uint32_t head = 0;
+    uint32_t sequence = 0;
+    uint16_t used = 0;
+    TsLogSummary summary;
+    uint16_t retention = TSLOG_RETENTION_DAYS;
+    TsLogCounters counters = {0};
+    SemaphoreHandle_t mutex = nullptr;
+    uint32_t offset(uint32_t sector) { return sector * TSLOG_SECTOR; }
+    bool readHeader(uint32_t sector, TsLogHeader *h);
+    bool readSummary(uint32_t sector, TsLogSummary *s);
+    bool readRecord(uint32_t sector, uint16_t index, TsLogRecord *r);
+    void openSector(uint32_t sector, uint32_t seq);
+    void closeSector();
+    void clearSummary(TsLogSummary *s);
+    void accountSummary(TsLogSummary *s, const TsLogRecord &r);
+    // Visit the records of [from, to], summaries of whole sectors when the visitor takes them
+    void scan(uint32_t from, uint32_t to, std::function<void(const TsLogRecord &)> record, std::function<bool(const TsLogSummary &)> whole);
+
+  public:
+    ~TsLog() {
+        if (mutex) {
+            vSemaphoreDelete(mutex);
+        }
+    }
+    // Mount the area, recover the tail after a crash or power loss
+    bool begin(TsLogFlash *area);
+    bool isReady() { return flash != nullptr && sectors > 1; }
+    // Erase the whole area
+    void format();
+    void append(const TsLogRecord &record);
+    // Values of a channel in [from, to], oldest first
+    uint32_t query(int channel, uint32_t from, uint32_t to, std::function<void(uint32_t, float)> callback);
+    // Min, max and mean of a channel in [from, to], whole sectors from their summaries
+    uint32_t summarize(int channel, uint32_t from, uint32_t to, float *min, float *max, float *mean);
+    // Every record held, oldest first
+    uint32_t replay(std::function<void(const TsLogRecord &)> callback);
+    void setRetention(uint16_t days) { retention = days; }
+    uint16_t getRetention() { return retention; }
+    uint32_t getSectors() { return sectors; }
+    uint32_t getRecords();
+    uint32_t getOldest();
+    uint32_t getNewest();
+    TsLogCounters getCounters() { return counters; }
+    void resetCounters() { counters = {0}; }
+};
+
+extern TsLog tslog;
+
+// Mount the partition and load the retention
+void initTsLog();
+void saveTsLogPrefs();
+// Aggregate a Meteo update (HistoryChannel order), a record per TSLOG_PERIOD into the log and rollups once the clock is set
+void tslogSample(uint32_t time, const float *values);
+const char *tslogChannelName(int channel);
+// Channel by name, -1 if unknown
+int tslogChannelFromString(String name);
+uint8_t tslogChannelDecimals(int channel);
+int16_t tslogQuantize(float value, int channel);
+float tslogDequantize(int16_t value, int channel);
+// Mean of count quantized values summing to sum
+float tslogMean(int64_t sum, uint32_t count, int channel);
+uint16_t tslogCrc(const void *data, uint32_t size);
@@ -0,0 +1,77 @@
+#include "turbulence.h"
+#include <esp_dsp.h>
+
+bool TurbulenceEstimator::begin() {
+    if (!inited) {
+        // Shared radix-2 twiddle table, allocated by ESP-DSP
+        esp_err_t err = dsps_fft2r_init_fc32(NULL, TURBULENCE_FFT_SIZE);
+        if (err != ESP_OK && err != ESP_ERR_DSP_REINITIALIZED) {
+            return false;
+        }
+        dsps_wind_hann_f32(window, TURBULENCE_FFT_SIZE);
+        windowPower = 0;
+        for (int i = 0; i < TURBULENCE_FFT_SIZE; i++) {
+            windowPower += window[i] * window[i];
+        }
+        inited = true;
+    }
+    clear();
+    return true;
+}
+
+void TurbulenceEstimator::add(float value) {
+    samples[head] = value;
+    head = (head + 1) % TURBULENCE_FFT_SIZE;
+    if (count < TURBULENCE_FFT_SIZE) {
+        count++;
+    }
+}
+
+void TurbulenceEstimator::clear() {
+    head = 0;
+    count = 0;
+    bandPower = 0;
+    totalPower = 0;
+}
+
+bool TurbulenceEstimator::compute(float sampleRateHz) {
+    if (!inited || !ready()) {
+        return false;
+    }
+    // Oldest sample first, mean removed
+    float mean = 0;
+    for (int i = 0; i < TURBULENCE_FFT_SIZE; i++) {
+        mean += samples[i];
+    }
+    mean /= TURBULENCE_FFT_SIZE;
+    for (int i = 0; i < TURBULENCE_FFT_SIZE; i++) {
+        fft[i * 2] = (samples[(head + i) % TURBULENCE_FFT_SIZE] - mean) * window[i];
+        fft[i * 2 + 1] = 0;
+    }
+    dsps_fft2r_fc32(fft, TURBULENCE_FFT_SIZE);
+    dsps_bit_rev_fc32(fft, TURBULENCE_FFT_SIZE);
+    // One-sided power spectrum, normalized so the bins sum to the signal variance
+    float binHz = sampleRateHz / TURBULENCE_FFT_SIZE;
+    float scale = 2. / (TURBULENCE_FFT_SIZE * windowPower);
+    float band = 0;
+    float total = 0;
+    for (int k = 1; k < TURBULENCE_FFT_SIZE / 2; k++) {
+        float re = fft[k * 2];
+        float im = fft[k * 2 + 1];
+        float p = (re * re + im * im) * scale;
+        total += p;
+        float f = k * binHz;
+        if (f >= TURBULENCE_BAND_LOW && f <= TURBULENCE_BAND_HIGH) {
+            band += p;
+        }
+    }
+    bandPower = band;
+    totalPower = total;
+    return true;
+}
+
+float TurbulenceEstimator::getIndex(int window) {
+    // Noise dB is 10 log10 of the sum of squared deviations, window times the variance
+    float power = bandPower * window;
+    return power > 0 ? 10 * log10(power) : 0;
+}
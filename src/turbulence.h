@@ -0,0 +1,42 @@
+#pragma once
+
+#include <Arduino.h>
+
+// High rate sky temperature sampling period, ms (MLX90614 native rate)
+#define TURBULENCE_SAMPLE_MS 100
+// FFT length, power of two
+#define TURBULENCE_FFT_SIZE 128
+// Turbulence band, Hz
+#define TURBULENCE_BAND_LOW 0.2
+#define TURBULENCE_BAND_HIGH 2.0
+
+// Band-limited sky temperature fluctuation power from an ESP-DSP FFT
+class TurbulenceEstimator {
+  private:
+    float samples[TURBULENCE_FFT_SIZE];
+    int head = 0;
+    int count = 0;
+    // Hann window and its power normalization
+    float window[TURBULENCE_FFT_SIZE];
+    float windowPower = 0;
+    // Interleaved re/im FFT buffer
+    float fft[TURBULENCE_FFT_SIZE * 2];
+    bool inited = false;
+    float bandPower = 0;
+    float totalPower = 0;
+
+  public:
+    bool begin();
+    void add(float value);
+    void clear();
+    // Buffer holds a full FFT frame
+    bool ready() { return count == TURBULENCE_FFT_SIZE; }
+    // Run the FFT over the last frame, true when the result was updated
+    bool compute(float sampleRateHz = 1000. / TURBULENCE_SAMPLE_MS);
+    // Fluctuation power in the turbulence band, °C²
+    float getBandPower() { return bandPower; }
+    // Fluctuation power over the whole spectrum except DC, °C²
+    float getTotalPower() { return totalPower; }
+    // Turbulence index on the noise dB scale, band power as the sum of squares over a window of samples
+    float getIndex(int window);
+};
@@ -0,0 +1,71 @@
+#include "warmstart.h"
+#include "tslog.h"
+#include <Preferences.h>
+#include <esp_attr.h>
+
+Preferences warmstartPrefs;
+
+RTC_NOINIT_ATTR WarmStartState warmstartState;
+// Built in RAM and copied at once, a reset while checkpointing loses less
+WarmStartState warmstartScratch;
+uint16_t warmstartMaxAge = WARMSTART_MAX_AGE;
+int32_t warmstartRestored = -1;
+
+void initWarmStart() {
+    warmstartPrefs.begin("warmstartPrefs", false);
+    warmstartMaxAge = warmstartPrefs.getUShort("maxage", WARMSTART_MAX_AGE);
+}
+
+void saveWarmStartPrefs() {
+    warmstartPrefs.putUShort("maxage", warmstartMaxAge);
+}
+
+uint16_t getWarmStartMaxAge() {
+    return warmstartMaxAge;
+}
+
+void setWarmStartMaxAge(uint16_t seconds) {
+    warmstartMaxAge = seconds;
+}
+
+void saveWarmStart(ObservingConditions *obscon, SafetyMonitor *safemon) {
+    uint32_t now = time(nullptr);
+    // Age needs the wall clock, it survives a software reset
+    if (now <= NTP_TIME_VALID) {
+        return;
+    }
+    warmstartScratch.magic = WARMSTART_MAGIC;
+    warmstartScratch.version = WARMSTART_VERSION;
+    warmstartScratch.size = sizeof(WarmStartState);
+    warmstartScratch.time = now;
+    obscon->checkpoint(&warmstartScratch.obscon);
+    safemon->checkpoint(&warmstartScratch.safemon);
+    warmstartScratch.crc = tslogCrc(&warmstartScratch, offsetof(WarmStartState, crc));
+    memcpy(&warmstartState, &warmstartScratch, sizeof(WarmStartState));
+}
+
+int32_t getWarmStartAge() {
+    uint32_t now = time(nullptr);
+    if (warmstartState.magic != WARMSTART_MAGIC || warmstartState.version != WARMSTART_VERSION || warmstartState.size != sizeof(WarmStartState)) {
+        return -1;
+    }
+    if (now <= NTP_TIME_VALID || now < warmstartState.time || warmstartState.crc != tslogCrc(&warmstartState, offsetof(WarmStartState, crc))) {
+        return -1;
+    }
+    return now - warmstartState.time;
+}
+
+int32_t getWarmStartRestored() {
+    return warmstartRestored;
+}
+
+int32_t restoreWarmStart(ObservingConditions *obscon, SafetyMonitor *safemon) {
+    int32_t age = getWarmStartAge();
+    if (warmstartMaxAge == 0 || age < 0 || age > warmstartMaxAge) {
+        return -1;
+    }
+    obscon->restore(&warmstartState.obscon, age);
+    safemon->restore(&warmstartState.safemon, age);
+    warmstartRestored = age;
+    return age;
+}
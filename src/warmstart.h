@@ -0,0 +1,37 @@
+#pragma once
+
+#include "observingconditions.h"
+#include "safetymonitor.h"
+#include <Arduino.h>
+
+#define WARMSTART_MAGIC 0x54534d57
+#define WARMSTART_VERSION 1
+// Oldest checkpoint restored at boot, seconds, 0 - always a cold start
+#define WARMSTART_MAX_AGE 900
+
+// Checkpoint in RTC memory, kept over software, watchdog and OTA resets but not a power loss
+struct WarmStartState {
+    uint32_t magic;
+    uint16_t version;
+    // A changed layout after an OTA is not restored
+    uint16_t size;
+    // Wall clock of the checkpoint
+    uint32_t time;
+    ObsconCheckpoint obscon;
+    SafemonCheckpoint safemon;
+    uint16_t crc;
+};
+
+// Load the maximum age
+void initWarmStart();
+void saveWarmStartPrefs();
+uint16_t getWarmStartMaxAge();
+void setWarmStartMaxAge(uint16_t seconds);
+// Checkpoint the averages and the safety state, after every update
+void saveWarmStart(ObservingConditions *obscon, SafetyMonitor *safemon);
+// Restore a checkpoint younger than the maximum age, its age or -1 for a cold start
+int32_t restoreWarmStart(ObservingConditions *obscon, SafetyMonitor *safemon);
+// Age of the held checkpoint, -1 if there is none
+int32_t getWarmStartAge();
+// Age restored at boot, -1 after a cold start
+int32_t getWarmStartRestored();
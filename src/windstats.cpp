@@ -0,0 +1,63 @@
+#include "windstats.h"
+
+void WindStatistics::closeSecond(uint64_t count) {
+    // Counter reset in between - the second is lost, count it as calm
+    uint32_t pulses = count >= secondStartCount ? (uint32_t)(count - secondStartCount) : 0;
+    counts2m.push(pulses);
+    counts10m.push(pulses);
+    gust2m.push(second, secondMax);
+    gust10m.push(second, secondMax);
+    secondStartCount = count;
+    secondMax = 0;
+}
+
+void WindStatistics::add(float frequency3s, uint64_t count, unsigned long nowMs) {
+    uint32_t now = nowMs / 1000;
+    // Start over after millis() overflow or a gap longer than the longest window
+    if (started && (now < second || now - second > WIND_WINDOW_10M)) {
+        clear();
+    }
+    if (!started) {
+        second = now;
+        secondStartCount = count;
+        started = true;
+    }
+    // Catch up on every elapsed second, pulses of a missed tick go to the first one
+    while (second < now) {
+        closeSecond(count);
+        second++;
+    }
+    mean3s = frequency3s;
+    if (frequency3s > secondMax) {
+        secondMax = frequency3s;
+    }
+}
+
+void WindStatistics::clear() {
+    counts2m.clear();
+    counts10m.clear();
+    gust2m.clear();
+    gust10m.clear();
+    secondMax = 0;
+    mean3s = 0;
+    started = false;
+}
+
+float WindStatistics::getMean2m() {
+    int filled = counts2m.getFilled();
+    return filled > 0 ? (float)counts2m.getSum() / filled : 0;
+}
+
+float WindStatistics::getMean10m() {
+    int filled = counts10m.getFilled();
+    return filled > 0 ? (float)counts10m.getSum() / filled : 0;
+}
+
+float WindStatistics::getGust2m() {
+    // Current second is not closed yet but already counts for gusts
+    return max(gust2m.getMax(), secondMax);
+}
+
+float WindStatistics::getGust10m() {
+    return max(gust10m.getMax(), secondMax);
+}
@@ -0,0 +1,105 @@
+#pragma once
+
+#include <Arduino.h>
+
+// Statistics tick, 3 s means are sampled at 4 Hz
+#define WIND_TICK_MS 250
+// Rolling mean window for gusts
+#define WIND_GUST_WINDOW_MS 3000
+// Sustained mean and gust windows, seconds
+#define WIND_WINDOW_2M 120
+#define WIND_WINDOW_10M 600
+
+// Sum of the last N per-second values, O(1) per push
+template <int N>
+class SlidingSum {
+  private:
+    uint32_t values[N] = {0};
+    uint64_t sum = 0;
+    int head = 0;
+    int filled = 0;
+
+  public:
+    void push(uint32_t value) {
+        if (filled == N) {
+            sum -= values[head];
+        } else {
+            filled++;
+        }
+        values[head] = value;
+        sum += value;
+        head = (head + 1) % N;
+    }
+    uint64_t getSum() { return sum; }
+    int getFilled() { return filled; }
+    void clear() {
+        sum = 0;
+        head = 0;
+        filled = 0;
+    }
+};
+
+// Maximum of the last N per-second values, monotonic deque, amortized O(1) per push
+template <int N>
+class SlidingMax {
+  private:
+    struct Entry {
+        uint32_t second;
+        float value;
+    };
+    // Values are non-increasing from front to back
+    Entry entries[N];
+    int front = 0;
+    int count = 0;
+
+  public:
+    void push(uint32_t second, float value) {
+        // Drop smaller values from the back, they can never be the maximum again
+        while (count > 0 && entries[(front + count - 1) % N].value <= value) {
+            count--;
+        }
+        // Drop expired values from the front
+        while (count > 0 && second - entries[front].second >= N) {
+            front = (front + 1) % N;
+            count--;
+        }
+        entries[(front + count) % N] = {second, value};
+        count++;
+    }
+    float getMax() { return count > 0 ? entries[front].value : 0; }
+    void clear() {
+        front = 0;
+        count = 0;
+    }
+};
+
+// Incremental WMO-style wind statistics from pulse counts and 3 s rolling means
+class WindStatistics {
+  private:
+    // Pulse counts per second for sustained means
+    SlidingSum<WIND_WINDOW_2M> counts2m;
+    SlidingSum<WIND_WINDOW_10M> counts10m;
+    // Maximum 3 s mean per second for gusts
+    SlidingMax<WIND_WINDOW_2M> gust2m;
+    SlidingMax<WIND_WINDOW_10M> gust10m;
+    // Current second accumulators
+    uint32_t second = 0;
+    float secondMax = 0;
+    uint64_t secondStartCount = 0;
+    bool started = false;
+    // Last 3 s rolling mean, Hz
+    float mean3s = 0;
+    // Close the current second and push it into the windows
+    void closeSecond(uint64_t count);
+
+  public:
+    // Add a 3 s mean frequency (Hz) and the running pulse counter at the given time
+    void add(float frequency3s, uint64_t count, unsigned long nowMs);
+    void clear();
+    // Frequencies in Hz
+    float getMean3s() { return mean3s; }
+    float getMean2m();
+    float getMean10m();
+    float getGust2m();
+    float getGust10m();
+};